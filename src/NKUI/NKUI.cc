@@ -15,14 +15,18 @@ void
 NKUI::Setup(const NKUISetup& setup) {
     o_assert_dbg(!IsValid());
     state = Memory::New<_state>();
-    state->nkuiWrapper.Setup(setup);
+    state->curInstance = CreateInstance(setup);
 }
 
 //------------------------------------------------------------------------------
 void
 NKUI::Discard() {
     o_assert_dbg(IsValid());
-    state->nkuiWrapper.Discard();
+    for (int i = 0; i < state->instances.Size(); i++) {
+        if (state->instances[i]) {
+            DestroyInstance(i);
+        }
+    }
     Memory::Delete(state);
     state = nullptr;
 }
@@ -33,61 +37,200 @@ NKUI::IsValid() {
     return nullptr != state;
 }
 
+//------------------------------------------------------------------------------
+int
+NKUI::CreateInstance(const NKUISetup& setup) {
+    o_assert_dbg(state);
+    // reuse the slot of a destroyed instance
+    int instance = state->instances.FindIndexLinear(nullptr);
+    if (InvalidIndex == instance) {
+        instance = state->instances.Size();
+        state->instances.Add(nullptr);
+    }
+    _priv::nkuiWrapper* wrapper = Memory::New<_priv::nkuiWrapper>();
+    wrapper->Setup(setup);
+    state->instances[instance] = wrapper;
+    return instance;
+}
+
+//------------------------------------------------------------------------------
+void
+NKUI::DestroyInstance(int instance) {
+    o_assert_dbg(IsValid());
+    o_assert_dbg(state->instances[instance]);
+    state->instances[instance]->Discard();
+    Memory::Delete(state->instances[instance]);
+    state->instances[instance] = nullptr;
+}
+
+//------------------------------------------------------------------------------
+void
+NKUI::SetInstance(int instance) {
+    o_assert_dbg(IsValid());
+    o_assert_dbg(state->instances[instance]);
+    state->curInstance = instance;
+}
+
+//------------------------------------------------------------------------------
+int
+NKUI::CurrentInstance() {
+    o_assert_dbg(IsValid());
+    return state->curInstance;
+}
+
+//------------------------------------------------------------------------------
+void
+NKUI::Composite(float x, float y, float width, float height) {
+    o_assert_dbg(IsValid());
+    cur().Composite(x, y, width, height);
+}
+
+//------------------------------------------------------------------------------
+Id
+NKUI::OffscreenTexture() {
+    o_assert_dbg(IsValid());
+    return cur().OffscreenTexture();
+}
+
 //------------------------------------------------------------------------------
 nk_context*
 NKUI::NewFrame() {
     o_assert_dbg(IsValid());
-    state->nkuiWrapper.NewFrame();
-    return &state->nkuiWrapper.ctx;
+    cur().NewFrame();
+    return &cur().ctx;
 }
 
 //------------------------------------------------------------------------------
 void
 NKUI::Draw() {
     o_assert_dbg(IsValid());
-    state->nkuiWrapper.Draw();
+    cur().Draw();
+}
+
+//------------------------------------------------------------------------------
+bool
+NKUI::NeedsUpdate() {
+    o_assert_dbg(IsValid());
+    return cur().NeedsUpdate();
+}
+
+//------------------------------------------------------------------------------
+void
+NKUI::RequestUpdate(Duration delay) {
+    o_assert_dbg(IsValid());
+    cur().RequestUpdate(delay);
+}
+
+//------------------------------------------------------------------------------
+void
+NKUI::BeginCapture(Buffer& capture) {
+    o_assert_dbg(IsValid());
+    cur().BeginCapture(capture);
+}
+
+//------------------------------------------------------------------------------
+void
+NKUI::EndCapture() {
+    o_assert_dbg(IsValid());
+    cur().EndCapture();
+}
+
+//------------------------------------------------------------------------------
+bool
+NKUI::ReplayFrame(const Buffer& capture, int& offset) {
+    o_assert_dbg(IsValid());
+    return cur().ReplayFrame(capture, offset);
 }
 
 //------------------------------------------------------------------------------
 struct nk_image
 NKUI::AllocImage() {
     o_assert_dbg(IsValid());
-    return state->nkuiWrapper.AllocImage();
+    return cur().AllocImage();
 }
 
 //------------------------------------------------------------------------------
 void
 NKUI::FreeImage(const struct nk_image& image) {
     o_assert_dbg(IsValid());
-    state->nkuiWrapper.FreeImage(image);
+    cur().FreeImage(image);
 }
 
 //------------------------------------------------------------------------------
 void
 NKUI::BindImage(const struct nk_image& image, Id texId) {
     o_assert_dbg(IsValid());
-    state->nkuiWrapper.BindImage(image, texId);
+    cur().BindImage(image, texId);
+}
+
+//------------------------------------------------------------------------------
+void
+NKUI::BindImagePixels(const struct nk_image& image, int width, int height, const void* pixels) {
+    o_assert_dbg(IsValid());
+    cur().BindImagePixels(image, width, height, pixels);
 }
 
 //------------------------------------------------------------------------------
 void
 NKUI::BeginFontAtlas() {
     o_assert_dbg(IsValid());
-    state->nkuiWrapper.BeginFontAtlas();
+    cur().BeginFontAtlas();
 }
 
 //------------------------------------------------------------------------------
 nk_font*
 NKUI::AddFont(const Buffer& ttfData, float fontHeight) {
     o_assert_dbg(IsValid());
-    return state->nkuiWrapper.AddFont(ttfData, fontHeight);
+    return cur().AddFont(ttfData, fontHeight);
 }
 
 //------------------------------------------------------------------------------
 void
 NKUI::EndFontAtlas() {
     o_assert_dbg(IsValid());
-    state->nkuiWrapper.EndFontAtlas();
+    cur().EndFontAtlas();
+}
+
+//------------------------------------------------------------------------------
+bool
+NKUI::EndFontAtlas(Buffer& cache) {
+    o_assert_dbg(IsValid());
+    return cur().EndFontAtlas(cache);
+}
+
+//------------------------------------------------------------------------------
+struct nk_user_font*
+NKUI::AddDynamicFont(const Buffer& ttfData, float fontHeight) {
+    o_assert_dbg(IsValid());
+    return cur().AddDynamicFont(ttfData, fontHeight);
+}
+
+//------------------------------------------------------------------------------
+struct nk_user_font*
+NKUI::AddSDFFont(const Buffer& ttfData, float baseHeight) {
+    o_assert_dbg(IsValid());
+    return cur().AddSDFFont(ttfData, baseHeight);
+}
+
+//------------------------------------------------------------------------------
+const NKUIStats&
+NKUI::Stats() {
+    o_assert_dbg(IsValid());
+    return cur().stats;
+}
+
+//------------------------------------------------------------------------------
+const NKUIFrameStats&
+NKUI::FrameStats() {
+    o_assert_dbg(IsValid());
+    return cur().FrameStats();
+}
+
+//------------------------------------------------------------------------------
+NKUIFrameTimings
+NKUI::FrameTimings() {
+    o_assert_dbg(IsValid());
+    return cur().FrameTimings();
 }
 
 } // namespace Oryol
@@ -7,10 +7,46 @@
     @class Oryol::NKUI
     @ingroup NKUI
     @brief facade of the NKUI module
+
+    NKUI can run several independent instances, each with its own
+    nuklear context, fonts, images and geometry. All functions
+    work on the current instance, Setup() creates instance 0.
+    Instances created with NKUISetup::Offscreen render into their own
+    render target, which is only re-rendered when its content changes,
+    and is drawn with Composite() as a single quad.
+
+    BeginCapture() records the input and the nuklear commands of each
+    frame into a blob, ReplayFrame() feeds them back frame by frame
+    through geometry conversion and submission (e.g. in a headless
+    instance for profiling). The replaying instance must create the
+    same fonts in the same order, images are replayed with their
+    captured handles, and custom draw commands are dropped.
+
+    With NKUISetup::TextWidthCache, the nk_user_font handles of all
+    fonts measure texts through a per-font width cache. The handle's
+    userdata then points to the cache instead of the nk_font, which
+    is only a problem for code calling the nk_font functions directly.
+
+    With NKUISetup::IdleFrames, the app may skip its UI code between
+    NewFrame() and Draw() while NeedsUpdate() returns false, and Draw()
+    re-presents the last frame. NKUI only sees nuklear input, so the app
+    must call RequestUpdate() when its UI changes for other reasons
+    (e.g. its own hotkeys, game state or timers), otherwise the old UI
+    stays on screen. Images bound or freed in an idle frame are handled
+    by rebuilding the geometry from the last frame's command stream.
+    Without IdleFrames, a frame without UI code draws an empty UI and
+    frees all windows.
+
+    NKUIListView draws lists and tables with millions of rows, only
+    the visible rows are submitted to nuklear.
 */
 #include "Core/Types.h"
+#include "Core/Containers/Array.h"
 #include "NKUI/nkuiWrapper.h"
 #include "NKUI/NKUISetup.h"
+#include "NKUI/NKUIStats.h"
+#include "NKUI/NKUIFrameStats.h"
+#include "NKUI/NKUIListView.h"
 
 namespace Oryol {
 
@@ -23,12 +59,36 @@ public:
     /// test if NKUI module has been setup
     static bool IsValid();
 
+    /// create an additional instance, returns the instance index
+    static int CreateInstance(const NKUISetup& setup);
+    /// destroy an instance created with CreateInstance()
+    static void DestroyInstance(int instance);
+    /// make an instance current for all other NKUI calls
+    static void SetInstance(int instance);
+    /// get the current instance
+    static int CurrentInstance();
+
     /// start a new frame (handles nuklear input)
     static nk_context* NewFrame();
     /// get pointer to nuklear context (if needed away from NewFrame())
     static nk_context* Ctx();
-    /// draw the nuklear UI
+    /// draw the nuklear UI, offscreen instances must be drawn outside of a render pass
     static void Draw();
+    /// draw the render target of an offscreen instance as a quad into the current pass (once per frame)
+    static void Composite(float x, float y, float width, float height);
+    /// get the render target texture of an offscreen instance (e.g. for in-world screens)
+    static Id OffscreenTexture();
+    /// after NewFrame(), false if nothing can have changed (with NKUISetup::IdleFrames the UI code may be skipped until Draw())
+    static bool NeedsUpdate();
+    /// request a UI update after a delay (e.g. for animations, or when displayed data changes)
+    static void RequestUpdate(Duration delay = Duration());
+
+    /// start appending each frame's input and nuklear commands to a capture blob (e.g. to save to a file)
+    static void BeginCapture(Buffer& capture);
+    /// stop capturing
+    static void EndCapture();
+    /// replay the next captured frame instead of NewFrame(), UI code and Draw(), returns false at the end
+    static bool ReplayFrame(const Buffer& capture, int& offset);
 
     /// allocate a new image handle
     static struct nk_image AllocImage();
@@ -36,6 +96,8 @@ public:
     static void FreeImage(const struct nk_image& image);
     /// bind an Oryol texture to an image handle
     static void BindImage(const struct nk_image& image, Id texId);
+    /// bind RGBA8 pixel data to an image handle, small images are packed into a shared atlas (NKUISetup::ImageAtlas)
+    static void BindImagePixels(const struct nk_image& image, int width, int height, const void* pixels);
 
     /// begin a font atlas
     static void BeginFontAtlas();
@@ -43,19 +105,43 @@ public:
     static nk_font* AddFont(const Buffer& ttfData, float fontHeight);
     /// end defining font atlas
     static void EndFontAtlas();
+    /// add a font which rasterizes glyphs on demand into a fixed-size glyph cache (for large unicode ranges)
+    static struct nk_user_font* AddDynamicFont(const Buffer& ttfData, float fontHeight);
+    /// add a dynamic SDF font, copy the returned nk_user_font and change its height to draw crisp text at any size
+    static struct nk_user_font* AddSDFFont(const Buffer& ttfData, float baseHeight);
+    /// end defining font atlas using a baked atlas cache, rebakes and updates the cache if stale, returns true if cache was used
+    static bool EndFontAtlas(Buffer& cache);
+
+    /// get runtime statistics
+    static const NKUIStats& Stats();
+    /// get performance counters and timings of the last frame
+    static const NKUIFrameStats& FrameStats();
+    /// get min/avg/max frame timings over the last FrameStatsWindowSize frames
+    static NKUIFrameTimings FrameTimings();
 
 private:
+    /// get the wrapper of the current instance
+    static _priv::nkuiWrapper& cur();
+
     struct _state {
-        _priv::nkuiWrapper nkuiWrapper;
+        /// destroyed instances are nullptr
+        Array<_priv::nkuiWrapper*> instances;
+        int curInstance = 0;
     };
     static _state* state;
 };
 
+//------------------------------------------------------------------------------
+inline _priv::nkuiWrapper&
+NKUI::cur() {
+    o_assert_dbg(state && state->instances[state->curInstance]);
+    return *state->instances[state->curInstance];
+}
+
 //------------------------------------------------------------------------------
 inline nk_context*
 NKUI::Ctx() {
-    o_assert_dbg(state);
-    return &state->nkuiWrapper.ctx;
+    return &cur().ctx;
 }
 
 } // namespace NKUI
@@ -0,0 +1,91 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::NKUIFrameStats
+    @brief per-frame performance counters and timings of the NKUI module
+
+    Conversion counters (vertices, indices, commands, ...) are 0 in
+    frames where RetainedMode skipped geometry generation.
+*/
+#include "Core/Types.h"
+#include "Core/Time/Duration.h"
+
+namespace Oryol {
+
+class NKUIFrameStats {
+public:
+    /// true if geometry generation was skipped (RetainedMode)
+    bool Skipped = false;
+    /// true if the app skipped its UI code and the last geometry was re-presented
+    bool Idle = false;
+    /// number of nuklear draw commands generated (before batching)
+    int NumNuklearCommands = 0;
+    /// number of nuklear draw commands dropped because they were clipped away
+    int NumCulledCommands = 0;
+    /// number of nuklear commands dropped because MaxNumChunks was exceeded or geometry memory ran out
+    int NumDroppedCommands = 0;
+    /// number of command stream segments (windows) converted
+    int NumSegments = 0;
+    /// number of geometry chunks (stream meshes) generated
+    int NumChunks = 0;
+    /// number of vertices generated
+    int NumVertices = 0;
+    /// number of indices generated
+    int NumIndices = 0;
+    /// number of quad instances generated (NKUISetup::InstancedQuads)
+    int NumInstances = 0;
+    /// number of bytes uploaded to vertex- and index-buffers
+    int NumUploadedBytes = 0;
+    /// index of the geometry buffer the geometry was uploaded to
+    int GeometryBuffer = 0;
+    /// number of draw calls (after batching)
+    int NumDrawCalls = 0;
+    /// number of texture switches
+    int NumTextureSwitches = 0;
+    /// number of draw state changes (texture and mesh switches)
+    int NumDrawStateChanges = 0;
+    /// number of scissor rect changes
+    int NumScissorRects = 0;
+    /// number of text widths measured by the UI code found in the text width caches (NKUISetup::TextWidthCache)
+    int NumTextWidthHits = 0;
+    /// number of text widths measured by the UI code not found in the text width caches
+    int NumTextWidthMisses = 0;
+
+    /// time spent in NKUI::NewFrame() (input handling)
+    Duration NewFrameTime;
+    /// time spent generating geometry
+    Duration ConvertTime;
+    /// time spent uploading geometry, glyph caches and image atlas pages (includes vertex quantization with CompactVertices)
+    Duration UploadTime;
+    /// time spent issuing draw calls
+    Duration SubmitTime;
+};
+
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::NKUIFrameTimings
+    @brief min/avg/max of NKUI frame timings over a rolling window of frames
+*/
+class NKUIFrameTimings {
+public:
+    /// min, average and max of one timing
+    struct Timing {
+        Duration Min;
+        Duration Avg;
+        Duration Max;
+    };
+    /// number of frames in the window
+    int NumFrames = 0;
+    /// NKUIFrameStats::NewFrameTime
+    Timing NewFrame;
+    /// NKUIFrameStats::ConvertTime
+    Timing Convert;
+    /// NKUIFrameStats::UploadTime
+    Timing Upload;
+    /// NKUIFrameStats::SubmitTime
+    Timing Submit;
+    /// sum of all the above
+    Timing Total;
+};
+
+} // namespace Oryol
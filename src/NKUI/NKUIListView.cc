@@ -0,0 +1,175 @@
+//------------------------------------------------------------------------------
+//  NKUIListView.cc
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "NKUIListView.h"
+#include <algorithm>
+
+#if __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include <stdio.h>
+#include "NKUI/nuklear_config.h"
+#include "nuklear/nuklear.h"
+#if __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+namespace Oryol {
+
+//------------------------------------------------------------------------------
+void
+NKUIListView::initIndex() {
+    o_assert_dbg(this->heights.Empty());
+    this->heights.Reserve(this->numRows);
+    this->offsets.Reserve(this->numRows + 1);
+    this->offsets.Add(0.0);
+    for (int i = 0; i < this->numRows; i++) {
+        this->heights.Add(this->defaultHeight);
+        this->offsets.Add(0.0);
+    }
+    this->dirtyRow = 0;
+}
+
+//------------------------------------------------------------------------------
+void
+NKUIListView::updateIndex() {
+    if (InvalidIndex != this->dirtyRow) {
+        for (int i = this->dirtyRow; i < this->numRows; i++) {
+            this->offsets[i + 1] = this->offsets[i] + this->heights[i];
+        }
+        this->dirtyRow = InvalidIndex;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+NKUIListView::SetNumRows(int numRows_, float rowHeight) {
+    o_assert_dbg((numRows_ >= 0) && (rowHeight > 0.0f));
+    if (this->heights.Empty() && ((0 == this->numRows) || (rowHeight == this->defaultHeight))) {
+        // all rows still have the same height, no index needed
+        this->numRows = numRows_;
+        this->defaultHeight = rowHeight;
+        return;
+    }
+    if (this->heights.Empty()) {
+        this->initIndex();
+    }
+    while (this->numRows > numRows_) {
+        this->heights.PopBack();
+        this->offsets.PopBack();
+        this->numRows--;
+    }
+    if (numRows_ > this->numRows) {
+        this->heights.Reserve(numRows_ - this->numRows);
+        this->offsets.Reserve(numRows_ - this->numRows);
+        for (int i = this->numRows; i < numRows_; i++) {
+            this->heights.Add(rowHeight);
+            this->offsets.Add(0.0);
+        }
+        this->dirtyRow = (InvalidIndex == this->dirtyRow) ? this->numRows : std::min(this->dirtyRow, this->numRows);
+        this->numRows = numRows_;
+    }
+    this->defaultHeight = rowHeight;
+}
+
+//------------------------------------------------------------------------------
+void
+NKUIListView::SetRowHeight(int row, float height) {
+    o_assert_dbg((row >= 0) && (row < this->numRows) && (height > 0.0f));
+    if (this->heights.Empty()) {
+        if (height == this->defaultHeight) {
+            return;
+        }
+        this->initIndex();
+    }
+    if (height != this->heights[row]) {
+        this->heights[row] = height;
+        this->dirtyRow = (InvalidIndex == this->dirtyRow) ? row : std::min(this->dirtyRow, row);
+    }
+}
+
+//------------------------------------------------------------------------------
+float
+NKUIListView::RowHeight(int row) const {
+    o_assert_dbg((row >= 0) && (row < this->numRows));
+    return this->heights.Empty() ? this->defaultHeight : this->heights[row];
+}
+
+//------------------------------------------------------------------------------
+double
+NKUIListView::rowTop(int row, float spacing) const {
+    const double top = this->heights.Empty() ? (double(row) * this->defaultHeight) : this->offsets[row];
+    return top + double(row) * spacing;
+}
+
+//------------------------------------------------------------------------------
+int
+NKUIListView::rowAt(double y, float spacing) const {
+    if (0 == this->numRows) {
+        return 0;
+    }
+    if (this->heights.Empty()) {
+        const int row = int(y / (double(this->defaultHeight) + spacing));
+        return std::min(std::max(row, 0), this->numRows - 1);
+    }
+    // last row which starts at or above y
+    int lo = 0;
+    int hi = this->numRows - 1;
+    while (lo < hi) {
+        const int mid = lo + (hi - lo + 1) / 2;
+        if (this->rowTop(mid, spacing) <= y) {
+            lo = mid;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+//------------------------------------------------------------------------------
+bool
+NKUIListView::Draw(nk_context* ctx, const char* name, uint32 flags, int numColumns, const RowFunc& drawRow) {
+    o_assert_dbg(ctx && name && (numColumns > 0) && drawRow);
+    this->updateIndex();
+    const float spacing = std::max(ctx->style.window.spacing.y, 0.0f);
+    if (InvalidIndex != this->scrollToRow) {
+        const int row = std::min(this->scrollToRow, this->numRows - 1);
+        this->scrollY = (row > 0) ? uint32(this->rowTop(row, spacing)) : 0;
+        this->scrollToRow = InvalidIndex;
+    }
+
+    // like nk_list_view, the group is scrolled only relative to the first
+    // drawn row while its content is laid out
+    const int first = std::max(this->rowAt(double(this->scrollY), spacing) - this->overscan, 0);
+    const uint32 base = std::min(uint32(this->rowTop(first, spacing)), this->scrollY);
+    this->scrollY -= base;
+    this->firstDrawnRow = first;
+    this->numDrawnRows = 0;
+    if (!nk_group_scrolled_offset_begin(ctx, &this->scrollX, &this->scrollY, name, flags)) {
+        this->scrollY += base;
+        return false;
+    }
+    struct nk_panel* layout = ctx->current->layout;
+    const double visibleBottom = double(base) + double(this->scrollY) + layout->clip.h;
+    int numBelow = 0;
+    for (int row = first; row < this->numRows; row++) {
+        if ((this->rowTop(row, spacing) >= visibleBottom) && (numBelow++ == this->overscan)) {
+            break;
+        }
+        nk_layout_row_dynamic(ctx, this->RowHeight(row), numColumns);
+        drawRow(ctx, row);
+        this->numDrawnRows++;
+    }
+
+    // the scrollbar gets the full list height and the absolute scroll
+    // offset back (same as nk_list_view_end())
+    layout->at_y = layout->bounds.y + float(this->rowTop(this->numRows, spacing));
+    this->scrollY += base;
+    nk_group_scrolled_end(ctx);
+    return true;
+}
+
+} // namespace Oryol
@@ -0,0 +1,113 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::NKUIListView
+    @ingroup NKUI
+    @brief virtualized scrolling list for very large row counts
+
+    Draws a scrolling nuklear group, but only calls the row callback
+    for the rows inside the visible area (plus a few overscan rows),
+    so the cost of a frame depends on the height of the list, not
+    on the number of rows. Like nk_list_view, the visible rows are laid
+    out relative to the first drawn row, and the full list height is
+    only given to the scrollbar, so that row positions keep their
+    precision in lists which are millions of pixels high.
+
+    Rows have the height passed to SetNumRows() unless changed with
+    SetRowHeight(). Individual row heights are kept in a prefix-sum
+    index, which is rebuilt from the first changed row in the next
+    Draw(), so appending rows is cheap.
+
+    The list view object must live as long as the list is shown,
+    since it owns the height index and the scroll position.
+*/
+#include "Core/Types.h"
+#include "Core/Assertion.h"
+#include "Core/Containers/Array.h"
+#include <functional>
+
+struct nk_context;
+
+namespace Oryol {
+
+class NKUIListView {
+public:
+    /// row callback, called after a layout row for the row has been started
+    typedef std::function<void(nk_context* ctx, int row)> RowFunc;
+
+    /// set the number of rows, new rows get the given height
+    void SetNumRows(int numRows, float rowHeight);
+    /// get the number of rows
+    int NumRows() const;
+    /// set the height of a row
+    void SetRowHeight(int row, float height);
+    /// get the height of a row
+    float RowHeight(int row) const;
+    /// set the number of extra rows drawn above and below the visible area (default: 2)
+    void SetOverscan(int numRows);
+    /// scroll a row to the top of the list in the next Draw()
+    void ScrollTo(int row);
+
+    /// draw the list into the current window, with numColumns dynamic columns per row, returns false if not visible
+    bool Draw(nk_context* ctx, const char* name, uint32 flags, int numColumns, const RowFunc& drawRow);
+    /// first row drawn by the last Draw()
+    int FirstDrawnRow() const;
+    /// number of rows drawn by the last Draw()
+    int NumDrawnRows() const;
+
+private:
+    /// switch from the default height to individual row heights
+    void initIndex();
+    /// rebuild the prefix sums from the first changed row
+    void updateIndex();
+    /// top of a row in the scrolled content, including item spacing
+    double rowTop(int row, float spacing) const;
+    /// find the row at a scroll offset
+    int rowAt(double y, float spacing) const;
+
+    int numRows = 0;
+    float defaultHeight = 0.0f;
+    /// individual row heights and their prefix sums (empty while all rows have the default height)
+    Array<float> heights;
+    Array<double> offsets;
+    int dirtyRow = InvalidIndex;
+    int overscan = 2;
+    int scrollToRow = InvalidIndex;
+    uint32 scrollX = 0;
+    uint32 scrollY = 0;
+    int firstDrawnRow = 0;
+    int numDrawnRows = 0;
+};
+
+//------------------------------------------------------------------------------
+inline int
+NKUIListView::NumRows() const {
+    return this->numRows;
+}
+
+//------------------------------------------------------------------------------
+inline void
+NKUIListView::SetOverscan(int numRows_) {
+    o_assert_dbg(numRows_ >= 0);
+    this->overscan = numRows_;
+}
+
+//------------------------------------------------------------------------------
+inline void
+NKUIListView::ScrollTo(int row) {
+    this->scrollToRow = row;
+}
+
+//------------------------------------------------------------------------------
+inline int
+NKUIListView::FirstDrawnRow() const {
+    return this->firstDrawnRow;
+}
+
+//------------------------------------------------------------------------------
+inline int
+NKUIListView::NumDrawnRows() const {
+    return this->numDrawnRows;
+}
+
+} // namespace Oryol
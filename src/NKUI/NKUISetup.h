@@ -5,6 +5,7 @@
     @brief configuration settings for Nuklear UI
 */
 #include "Core/Types.h"
+#include "Core/Containers/Buffer.h"
 
 namespace Oryol {
 
@@ -24,6 +25,84 @@ public:
     int CurveSegmentCount = 22;
     /// arc segment count (for vectorization)
     int ArcSegmentCount = 22;
+    /// pick circle, arc and curve segment counts from their on-screen size instead of the fixed counts above
+    bool AdaptiveTessellation = false;
+    /// max distance in pixels between an adaptively tessellated shape and the true shape
+    float TessellationTolerance = 0.25f;
+    /// max segments of an adaptively tessellated full circle or curve
+    int MaxSegmentCount = 120;
+    /// initial number of vertices in the CPU-side vertex buffer (grows on demand)
+    int InitialNumVertices = 16 * 1024;
+    /// initial number of indices in the CPU-side index buffer (grows on demand)
+    int InitialNumIndices = 32 * 1024;
+    /// max number of vertices per geometry chunk (each chunk is a 16-bit indexed stream mesh)
+    int ChunkNumVertices = 64 * 1024;
+    /// max number of indices per geometry chunk
+    int ChunkNumIndices = 128 * 1024;
+    /// max number of geometry chunks, additional meshes are created on demand
+    int MaxNumChunks = 16;
+    /// number of stream mesh sets used round-robin for geometry upload (should be >= the number of frames in flight)
+    int NumGeometryBuffers = 1;
+    /// upload vertices as 12-byte quantized vertices (quarter-pixel positions, 16-bit UVs) instead of 20-byte float vertices
+    bool CompactVertices = false;
+    /// render rects, circles, straight lines, text and images as instanced quads instead of tessellating them
+    bool InstancedQuads = false;
+    /// max number of instances per instanced draw command (each has its own instance stream mesh)
+    int ChunkNumInstances = 4 * 1024;
+    /// max number of instanced draw commands per frame
+    int MaxNumInstChunks = 256;
+    /// size of a fixed memory block for the nuklear context (UI commands and window state), 0: grow on demand
+    int ContextMemorySize = 0;
+    /// soft memory budget for the draw command buffer in bytes (0: unlimited), overruns are logged once and counted in NKUIStats
+    int CommandMemoryBudget = 0;
+    /// soft memory budget for CPU-side vertex- and index-data in bytes (0: unlimited)
+    int GeometryMemoryBudget = 0;
+    /// soft memory budget for font atlases in bytes (0: unlimited)
+    int FontAtlasMemoryBudget = 0;
+    /// bake font atlases into single-channel alpha textures (4x less texture memory)
+    bool AlphaFontAtlas = false;
+    /// width and height of the glyph cache textures for NKUI::AddDynamicFont() and NKUI::AddSDFFont()
+    int GlyphCacheSize = 1024;
+    /// cache the widths of measured texts per font (cached widths are identical to measured widths)
+    bool TextWidthCache = false;
+    /// max number of cached text widths per font
+    int TextWidthCacheSize = 2048;
+    /// distance range of SDF glyphs in pixels at the font's base height
+    float SDFSpread = 4.0f;
+    /// optional baked atlas cache for the default font, loaded from if valid, otherwise (re-)written
+    Buffer* DefaultFontAtlasCache = nullptr;
+    /// initial capacity of the image handle table (grows on demand)
+    int InitialNumImages = 256;
+    /// pack small images bound with NKUI::BindImagePixels() into shared atlas textures
+    bool ImageAtlas = false;
+    /// width and height of an image atlas page in pixels
+    int ImageAtlasPageSize = 1024;
+    /// max width and height of images which go into the image atlas
+    int ImageAtlasMaxImageSize = 64;
+    /// max number of image atlas pages
+    int ImageAtlasMaxNumPages = 8;
+    /// number of frames in the rolling window for NKUI::FrameTimings()
+    int FrameStatsWindowSize = 120;
+    /// headless mode: don't touch Gfx and Input, only run the CPU side (for benchmarks)
+    bool Headless = false;
+    /// framebuffer width in headless mode
+    int HeadlessWidth = 1280;
+    /// framebuffer height in headless mode
+    int HeadlessHeight = 720;
+    /// render into an offscreen render target, which is only re-rendered when the UI changes
+    bool Offscreen = false;
+    /// width of the offscreen render target
+    int OffscreenWidth = 512;
+    /// height of the offscreen render target
+    int OffscreenHeight = 512;
+    /// number of worker threads for parallel per-window geometry conversion (0: main thread only)
+    int NumConvertThreads = 0;
+    /// skip vertex generation and upload if the UI hasn't changed since last frame
+    bool RetainedMode = false;
+    /// allow the app to skip its UI code while NKUI::NeedsUpdate() is false, Draw() then re-presents the last frame
+    bool IdleFrames = false;
+    /// NKUI::NeedsUpdate() stays true for this many frames after input or an update request
+    int IdleSettleFrames = 2;
 };
 
 } // namespace Oryol
@@ -0,0 +1,58 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::NKUIStats
+    @brief runtime statistics of the NKUI module
+*/
+#include "Core/Types.h"
+
+namespace Oryol {
+
+class NKUIStats {
+public:
+    /// memory usage of one of the NKUI memory pools
+    struct MemoryUsage {
+        /// currently allocated bytes
+        int CurrentBytes = 0;
+        /// high-water mark in bytes
+        int PeakBytes = 0;
+        /// memory budget in bytes (0: unlimited)
+        int BudgetBytes = 0;
+        /// total number of heap allocations
+        int NumAllocs = 0;
+        /// number of allocations which exceeded the budget (budgets are soft, the allocations still succeed)
+        int NumBudgetOverruns = 0;
+    };
+    /// nuklear context memory (UI commands and window state), NumBudgetOverruns counts frames where a fixed context block was full
+    MemoryUsage ContextMemory;
+    /// draw command buffer memory
+    MemoryUsage CommandMemory;
+    /// CPU-side vertex- and index-buffer memory
+    MemoryUsage GeometryMemory;
+    /// font atlas memory
+    MemoryUsage FontAtlasMemory;
+    /// CPU-side image atlas pages
+    MemoryUsage ImageAtlasMemory;
+
+    /// number of currently allocated image handles
+    int NumImages = 0;
+    /// number of glyphs in the dynamic font glyph cache
+    int NumCachedGlyphs = 0;
+    /// number of glyphs evicted from the glyph cache
+    int NumGlyphCacheEvictions = 0;
+    /// number of glyphs which didn't fit into the glyph cache (drawn as blanks)
+    int NumGlyphCacheOverflows = 0;
+    /// number of text widths in the text width caches (NKUISetup::TextWidthCache)
+    int NumCachedTextWidths = 0;
+    /// number of text widths evicted from the text width caches
+    int NumTextWidthCacheEvictions = 0;
+
+    /// number of frames where geometry generation and upload was skipped (RetainedMode)
+    int NumSkippedFrames = 0;
+    /// number of idle frames where the app skipped its UI code and the last geometry was re-presented
+    int NumIdleFrames = 0;
+    /// number of times geometry upload wrapped around to the first geometry buffer (NKUISetup::NumGeometryBuffers)
+    int NumGeometryBufferWraps = 0;
+};
+
+} // namespace Oryol
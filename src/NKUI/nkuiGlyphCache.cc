@@ -0,0 +1,190 @@
+//------------------------------------------------------------------------------
+//  nkuiGlyphCache.cc
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "nkuiGlyphCache.h"
+#include "Core/Assertion.h"
+#include "Core/Memory/Memory.h"
+#include <algorithm>
+
+namespace Oryol {
+namespace _priv {
+
+//------------------------------------------------------------------------------
+void
+nkuiGlyphCache::Setup(int size_) {
+    o_assert_dbg(!this->IsValid());
+    o_assert_dbg(size_ >= 64);
+    this->size = size_;
+    this->pixels = (uint8*) Memory::Alloc(size_ * size_);
+    Memory::Clear(this->pixels, size_ * size_);
+    this->nextRowY = 0;
+    this->frame = 1;
+    this->dirty = true;
+    this->numGlyphs = 0;
+    this->numEvictions = 0;
+    this->numOverflows = 0;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiGlyphCache::Discard() {
+    o_assert_dbg(this->IsValid());
+    Memory::Free(this->pixels);
+    this->pixels = nullptr;
+    this->rows.Clear();
+    this->cellMap.Clear();
+}
+
+//------------------------------------------------------------------------------
+const nkuiGlyphCache::glyph*
+nkuiGlyphCache::Lookup(uint32 key) {
+    const int mapIndex = this->cellMap.FindIndex(key);
+    if (InvalidIndex == mapIndex) {
+        return nullptr;
+    }
+    const int cellIndex = this->cellMap.ValueAtIndex(mapIndex);
+    cell& c = this->rows[cellIndex >> 16].cells[cellIndex & 0xFFFF];
+    c.lastUsed = this->frame;
+    return &c.g;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiGlyphCache::evict(cell& c) {
+    o_assert_dbg(c.used);
+    this->cellMap.Erase(c.key);
+    c.used = false;
+    this->numGlyphs--;
+    this->numEvictions++;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiGlyphCache::initRow(row& r, int cellSize) {
+    r.cellSize = cellSize;
+    r.cells.Clear();
+    const int numCells = this->size / cellSize;
+    r.cells.Reserve(numCells);
+    for (int i = 0; i < numCells; i++) {
+        r.cells.Add(cell());
+    }
+}
+
+//------------------------------------------------------------------------------
+nkuiGlyphCache::glyph*
+nkuiGlyphCache::Alloc(uint32 key, int width, int height, int& outX, int& outY) {
+    o_assert_dbg(this->IsValid());
+    o_assert_dbg(!this->cellMap.Contains(key));
+    const int cellSize = (std::max(width, height) + 1 + 7) & ~7;
+    if (cellSize > this->size) {
+        this->numOverflows++;
+        return nullptr;
+    }
+
+    int rowIndex = InvalidIndex;
+    int colIndex = InvalidIndex;
+
+    // 1. a free cell in a row of the same cell size
+    for (int r = 0; (r < this->rows.Size()) && (InvalidIndex == rowIndex); r++) {
+        const row& rw = this->rows[r];
+        if (rw.cellSize == cellSize) {
+            for (int c = 0; c < rw.cells.Size(); c++) {
+                if (!rw.cells[c].used) {
+                    rowIndex = r;
+                    colIndex = c;
+                    break;
+                }
+            }
+        }
+    }
+
+    // 2. a new row
+    if ((InvalidIndex == rowIndex) && ((this->nextRowY + cellSize) <= this->size)) {
+        row rw;
+        rw.y = this->nextRowY;
+        rw.height = cellSize;
+        this->nextRowY += cellSize;
+        this->initRow(rw, cellSize);
+        rowIndex = this->rows.Size();
+        colIndex = 0;
+        this->rows.Add(rw);
+    }
+
+    // 3. the least recently used cell of the same size
+    if (InvalidIndex == rowIndex) {
+        uint32 oldest = this->frame;
+        for (int r = 0; r < this->rows.Size(); r++) {
+            const row& rw = this->rows[r];
+            if (rw.cellSize == cellSize) {
+                for (int c = 0; c < rw.cells.Size(); c++) {
+                    if (rw.cells[c].lastUsed < oldest) {
+                        oldest = rw.cells[c].lastUsed;
+                        rowIndex = r;
+                        colIndex = c;
+                    }
+                }
+            }
+        }
+        if (InvalidIndex != rowIndex) {
+            this->evict(this->rows[rowIndex].cells[colIndex]);
+        }
+    }
+
+    // 4. recycle the least recently used row which is high enough
+    if (InvalidIndex == rowIndex) {
+        uint32 oldest = this->frame;
+        for (int r = 0; r < this->rows.Size(); r++) {
+            const row& rw = this->rows[r];
+            if (rw.height >= cellSize) {
+                uint32 rowLastUsed = 0;
+                for (const cell& c : rw.cells) {
+                    rowLastUsed = std::max(rowLastUsed, c.used ? c.lastUsed : 0);
+                }
+                if (rowLastUsed < oldest) {
+                    oldest = rowLastUsed;
+                    rowIndex = r;
+                }
+            }
+        }
+        if (InvalidIndex != rowIndex) {
+            row& rw = this->rows[rowIndex];
+            for (cell& c : rw.cells) {
+                if (c.used) {
+                    this->evict(c);
+                }
+            }
+            this->initRow(rw, cellSize);
+            colIndex = 0;
+        }
+    }
+    if (InvalidIndex == rowIndex) {
+        this->numOverflows++;
+        return nullptr;
+    }
+
+    // clear the cell and setup the glyph's UVs
+    const row& rw = this->rows[rowIndex];
+    outX = colIndex * rw.cellSize;
+    outY = rw.y;
+    for (int y = 0; y < rw.cellSize; y++) {
+        Memory::Clear(this->pixels + (outY + y) * this->size + outX, rw.cellSize);
+    }
+    cell& c = this->rows[rowIndex].cells[colIndex];
+    c.key = key;
+    c.lastUsed = this->frame;
+    c.used = true;
+    c.g = glyph();
+    const float s = 1.0f / float(this->size);
+    c.g.u0 = float(outX) * s;
+    c.g.v0 = float(outY) * s;
+    c.g.u1 = float(outX + width) * s;
+    c.g.v1 = float(outY + height) * s;
+    this->cellMap.Add(key, (rowIndex << 16) | colIndex);
+    this->numGlyphs++;
+    this->dirty = true;
+    return &c.g;
+}
+
+} // namespace _priv
+} // namespace Oryol
@@ -0,0 +1,153 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::_priv::nkuiGlyphCache
+    @brief fixed-size alpha texture cache for on-demand rasterized glyphs
+
+    Glyphs are placed into square cells (size rounded up to a multiple
+    of 8 pixels), cells of the same size are organized into rows. When
+    the cache is full, the least recently used glyph of the same cell
+    size is evicted, or a whole row of a different cell size is recycled.
+    Glyphs used in the current frame are never evicted, since geometry
+    referencing them may already have been generated.
+
+    The cache itself isn't thread-safe, the NKUI wrapper guards it
+    with a mutex since glyphs are queried during geometry conversion.
+*/
+#include "Core/Types.h"
+#include "Core/Containers/Array.h"
+#include "Core/Containers/Map.h"
+
+namespace Oryol {
+namespace _priv {
+
+class nkuiGlyphCache {
+public:
+    /// a cached glyph, positions relative to the top-left of the text line
+    struct glyph {
+        float x0 = 0.0f;
+        float y0 = 0.0f;
+        float x1 = 0.0f;
+        float y1 = 0.0f;
+        float u0 = 0.0f;
+        float v0 = 0.0f;
+        float u1 = 0.0f;
+        float v1 = 0.0f;
+        float xadvance = 0.0f;
+    };
+
+    /// setup with texture width and height in pixels
+    void Setup(int size);
+    /// discard the cache
+    void Discard();
+    /// test if the cache has been setup
+    bool IsValid() const;
+    /// start a new frame (glyphs used in current frame are not evicted)
+    void NewFrame();
+    /// lookup a glyph and mark as used, returns nullptr if not cached
+    const glyph* Lookup(uint32 key);
+    /// allocate a cell for a glyph bitmap, returns nullptr if cache is full of current-frame glyphs
+    glyph* Alloc(uint32 key, int width, int height, int& outX, int& outY);
+
+    /// get the alpha pixels
+    uint8* Pixels() const;
+    /// width and height of the cache texture
+    int Size() const;
+    /// test if pixels have changed since ClearDirty()
+    bool Dirty() const;
+    /// clear the dirty flag after upload
+    void ClearDirty();
+    /// number of cached glyphs
+    int NumGlyphs() const;
+    /// number of evicted glyphs since setup
+    int NumEvictions() const;
+    /// number of glyphs that didn't fit since setup
+    int NumOverflows() const;
+
+private:
+    struct cell {
+        uint32 key = 0;
+        uint32 lastUsed = 0;
+        bool used = false;
+        glyph g;
+    };
+    struct row {
+        int y = 0;
+        int height = 0;
+        int cellSize = 0;
+        Array<cell> cells;
+    };
+    /// evict a cell
+    void evict(cell& c);
+    /// (re-)initialize the cells of a row for a cell size
+    void initRow(row& r, int cellSize);
+
+    uint8* pixels = nullptr;
+    int size = 0;
+    int nextRowY = 0;
+    uint32 frame = 1;
+    bool dirty = false;
+    int numGlyphs = 0;
+    int numEvictions = 0;
+    int numOverflows = 0;
+    Array<row> rows;
+    /// maps glyph keys to (row << 16) | column
+    Map<uint32, int> cellMap;
+};
+
+//------------------------------------------------------------------------------
+inline bool
+nkuiGlyphCache::IsValid() const {
+    return nullptr != this->pixels;
+}
+
+//------------------------------------------------------------------------------
+inline void
+nkuiGlyphCache::NewFrame() {
+    this->frame++;
+}
+
+//------------------------------------------------------------------------------
+inline uint8*
+nkuiGlyphCache::Pixels() const {
+    return this->pixels;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiGlyphCache::Size() const {
+    return this->size;
+}
+
+//------------------------------------------------------------------------------
+inline bool
+nkuiGlyphCache::Dirty() const {
+    return this->dirty;
+}
+
+//------------------------------------------------------------------------------
+inline void
+nkuiGlyphCache::ClearDirty() {
+    this->dirty = false;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiGlyphCache::NumGlyphs() const {
+    return this->numGlyphs;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiGlyphCache::NumEvictions() const {
+    return this->numEvictions;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiGlyphCache::NumOverflows() const {
+    return this->numOverflows;
+}
+
+} // namespace _priv
+} // namespace Oryol
@@ -0,0 +1,300 @@
+//------------------------------------------------------------------------------
+//  nkuiImageAtlas.cc
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "nkuiImageAtlas.h"
+#include "Core/Assertion.h"
+#include "Core/Memory/Memory.h"
+#include <algorithm>
+
+namespace Oryol {
+namespace _priv {
+
+//------------------------------------------------------------------------------
+void
+nkuiImageAtlas::Setup(int pageSize_, int maxNumPages_) {
+    o_assert_dbg((pageSize_ > 0) && (maxNumPages_ > 0));
+    this->pageSize = pageSize_;
+    this->maxNumPages = maxNumPages_;
+    this->pages.Reserve(maxNumPages_);
+    this->usage = NKUIStats::MemoryUsage();
+    this->usage.BudgetBytes = maxNumPages_ * this->PageByteSize();
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiImageAtlas::Discard() {
+    for (page& p : this->pages) {
+        if (p.pixels) {
+            Memory::Free(p.pixels);
+            p.pixels = nullptr;
+        }
+    }
+    this->pages.Clear();
+    this->entries.Clear();
+    this->freeEntries.Clear();
+    this->usage.CurrentBytes = 0;
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiImageAtlas::newPage() {
+    int pageIndex = InvalidIndex;
+    for (int i = 0; i < this->pages.Size(); i++) {
+        if (!this->pages[i].pixels) {
+            pageIndex = i;
+            break;
+        }
+    }
+    if (InvalidIndex == pageIndex) {
+        if (this->pages.Size() >= this->maxNumPages) {
+            return InvalidIndex;
+        }
+        pageIndex = this->pages.Size();
+        this->pages.Add(page());
+    }
+    page& p = this->pages[pageIndex];
+    p.pixels = (uint8*) Memory::Alloc(this->PageByteSize());
+    Memory::Clear(p.pixels, this->PageByteSize());
+    p.shelves.Clear();
+    p.numEntries = 0;
+    p.usedArea = 0;
+    p.dirty = true;
+    this->usage.CurrentBytes += this->PageByteSize();
+    this->usage.PeakBytes = std::max(this->usage.PeakBytes, this->usage.CurrentBytes);
+    this->usage.NumAllocs++;
+    return pageIndex;
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiImageAtlas::findSpot(const Array<shelf>& shelves, int w, int h, int& outShelf, int& outX, int& outY) const {
+
+    // best-fit into an existing shelf...
+    int bestShelf = InvalidIndex;
+    int bestWaste = this->pageSize;
+    for (int i = 0; i < shelves.Size(); i++) {
+        const shelf& s = shelves[i];
+        if ((s.height >= h) && ((s.x + w) <= this->pageSize) && ((s.height - h) < bestWaste)) {
+            bestShelf = i;
+            bestWaste = s.height - h;
+        }
+    }
+
+    // ...but prefer a new shelf if the best fit would waste more
+    // than the image height
+    if ((InvalidIndex == bestShelf) || (bestWaste > h)) {
+        const int y = shelves.Empty() ? 0 : shelves.Back().y + shelves.Back().height;
+        if ((y + h) <= this->pageSize) {
+            outShelf = shelves.Size();
+            outX = 0;
+            outY = y;
+            return true;
+        }
+    }
+    if (InvalidIndex != bestShelf) {
+        outShelf = bestShelf;
+        outX = shelves[bestShelf].x;
+        outY = shelves[bestShelf].y;
+        return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiImageAtlas::insert(page& p, int w, int h, int& outX, int& outY) const {
+    int shelfIndex;
+    if (!this->findSpot(p.shelves, w, h, shelfIndex, outX, outY)) {
+        return false;
+    }
+    if (shelfIndex == p.shelves.Size()) {
+        shelf s;
+        s.y = outY;
+        s.height = h;
+        p.shelves.Add(s);
+    }
+    p.shelves[shelfIndex].x += w;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiImageAtlas::blit(uint8* dst, int x, int y, int w, int h, const uint8* src, int srcPitch) const {
+    // (x, y) is the top-left of the padded rect, the border
+    // pixels replicate the image edges
+    const int dstPitch = this->pageSize * 4;
+    for (int row = -1; row <= h; row++) {
+        const int srcRow = std::min(std::max(row, 0), h - 1);
+        const uint8* srcPtr = src + srcRow * srcPitch;
+        uint8* dstPtr = dst + (y + 1 + row) * dstPitch + x * 4;
+        Memory::Copy(srcPtr, dstPtr, 4);
+        Memory::Copy(srcPtr, dstPtr + 4, w * 4);
+        Memory::Copy(srcPtr + (w - 1) * 4, dstPtr + (w + 1) * 4, 4);
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiImageAtlas::updateUV(entry& e) const {
+    const float s = 1.0f / float(this->pageSize);
+    e.uv[0] = float(e.x + 1) * s;
+    e.uv[1] = float(e.y + 1) * s;
+    e.uv[2] = float(e.x + 1 + e.width) * s;
+    e.uv[3] = float(e.y + 1 + e.height) * s;
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiImageAtlas::Add(int width, int height, const void* pixels) {
+    o_assert_dbg((width > 0) && (height > 0) && pixels);
+    const int w = width + 2;
+    const int h = height + 2;
+    if ((w > this->pageSize) || (h > this->pageSize)) {
+        return InvalidIndex;
+    }
+
+    // try existing pages first, compact a page if it has enough free
+    // space in total but too fragmented, and start a new page last
+    int pageIndex = InvalidIndex;
+    int x = 0, y = 0;
+    for (int i = 0; i < this->pages.Size(); i++) {
+        page& p = this->pages[i];
+        if (!p.pixels) {
+            continue;
+        }
+        if (this->insert(p, w, h, x, y)) {
+            pageIndex = i;
+            break;
+        }
+        const int freeArea = this->pageSize * this->pageSize - p.usedArea;
+        if ((freeArea >= (w * h)) && this->compact(i) && this->insert(this->pages[i], w, h, x, y)) {
+            pageIndex = i;
+            break;
+        }
+    }
+    if (InvalidIndex == pageIndex) {
+        pageIndex = this->newPage();
+        if ((InvalidIndex == pageIndex) || !this->insert(this->pages[pageIndex], w, h, x, y)) {
+            return InvalidIndex;
+        }
+    }
+
+    int entryIndex;
+    if (this->freeEntries.Empty()) {
+        entryIndex = this->entries.Size();
+        this->entries.Add(entry());
+    }
+    else {
+        entryIndex = this->freeEntries.PopBack();
+    }
+    entry& e = this->entries[entryIndex];
+    e.page = pageIndex;
+    e.x = x;
+    e.y = y;
+    e.width = width;
+    e.height = height;
+    this->updateUV(e);
+
+    page& p = this->pages[pageIndex];
+    this->blit(p.pixels, x, y, width, height, (const uint8*)pixels, width * 4);
+    p.numEntries++;
+    p.usedArea += w * h;
+    p.dirty = true;
+    return entryIndex;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiImageAtlas::Remove(int entryIndex) {
+    entry& e = this->entries[entryIndex];
+    o_assert_dbg(InvalidIndex != e.page);
+    page& p = this->pages[e.page];
+    const int w = e.width + 2;
+    const int h = e.height + 2;
+    p.numEntries--;
+    p.usedArea -= w * h;
+    if (0 == p.numEntries) {
+        // evict the page
+        Memory::Free(p.pixels);
+        p.pixels = nullptr;
+        p.shelves.Clear();
+        p.usedArea = 0;
+        p.dirty = false;
+        this->usage.CurrentBytes -= this->PageByteSize();
+    }
+    else {
+        // if this was the rightmost image in its shelf, give the space back
+        for (shelf& s : p.shelves) {
+            if ((s.y == e.y) && ((e.x + w) == s.x)) {
+                s.x = e.x;
+                break;
+            }
+        }
+    }
+    e.page = InvalidIndex;
+    this->freeEntries.Add(entryIndex);
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiImageAtlas::compact(int pageIndex) {
+    page& p = this->pages[pageIndex];
+
+    // gather the page's images, tallest first
+    Array<int> indices;
+    indices.Reserve(p.numEntries);
+    for (int i = 0; i < this->entries.Size(); i++) {
+        if (this->entries[i].page == pageIndex) {
+            indices.Add(i);
+        }
+    }
+    std::sort(indices.begin(), indices.end(), [this](int a, int b) {
+        return this->entries[a].height > this->entries[b].height;
+    });
+
+    // compute the new layout first, and leave the page alone if it doesn't work out
+    Array<shelf> shelves;
+    Array<int> positions;
+    positions.Reserve(indices.Size() * 2);
+    for (int i : indices) {
+        const entry& e = this->entries[i];
+        int shelfIndex, x, y;
+        if (!this->findSpot(shelves, e.width + 2, e.height + 2, shelfIndex, x, y)) {
+            return false;
+        }
+        if (shelfIndex == shelves.Size()) {
+            shelf s;
+            s.y = y;
+            s.height = e.height + 2;
+            shelves.Add(s);
+        }
+        shelves[shelfIndex].x += e.width + 2;
+        positions.Add(x);
+        positions.Add(y);
+    }
+
+    // move the padded images from a copy of the old page
+    const int pitch = this->pageSize * 4;
+    uint8* old = (uint8*) Memory::Alloc(this->PageByteSize());
+    Memory::Copy(p.pixels, old, this->PageByteSize());
+    Memory::Clear(p.pixels, this->PageByteSize());
+    for (int i = 0; i < indices.Size(); i++) {
+        entry& e = this->entries[indices[i]];
+        const int x = positions[i * 2 + 0];
+        const int y = positions[i * 2 + 1];
+        for (int row = 0; row < (e.height + 2); row++) {
+            Memory::Copy(old + (e.y + row) * pitch + e.x * 4, p.pixels + (y + row) * pitch + x * 4, (e.width + 2) * 4);
+        }
+        e.x = x;
+        e.y = y;
+        this->updateUV(e);
+    }
+    Memory::Free(old);
+    p.shelves = shelves;
+    p.dirty = true;
+    return true;
+}
+
+} // namespace _priv
+} // namespace Oryol
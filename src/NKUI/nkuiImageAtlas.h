@@ -0,0 +1,160 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::_priv::nkuiImageAtlas
+    @brief shelf-packed RGBA8 atlas pages for small user images
+
+    Keeps a CPU-side copy of each page, the NKUI wrapper creates and
+    updates the page textures. Images are padded by a 1-pixel border
+    with replicated edge pixels so that linear filtering doesn't bleed.
+    When an image doesn't fit into a page with enough free area, the
+    page is compacted (repacked tallest-first), pages which become
+    empty are evicted.
+
+    The UV rect of an image changes when its page is compacted, so
+    UV rects must be looked up at draw time.
+*/
+#include "Core/Types.h"
+#include "Core/Containers/Array.h"
+#include "NKUI/NKUIStats.h"
+
+namespace Oryol {
+namespace _priv {
+
+class nkuiImageAtlas {
+public:
+    /// setup with page size in pixels and max number of pages
+    void Setup(int pageSize, int maxNumPages);
+    /// discard the atlas and free all pages
+    void Discard();
+    /// add an RGBA8 image, returns InvalidIndex if it doesn't fit
+    int Add(int width, int height, const void* pixels);
+    /// remove an image, the page is evicted if it becomes empty
+    void Remove(int entryIndex);
+
+    /// get page index of an image
+    int Page(int entryIndex) const;
+    /// get UV rect of an image (u0, v0, u1, v1)
+    const float* UVRect(int entryIndex) const;
+    /// number of page slots (including evicted pages)
+    int NumPages() const;
+    /// test if a page slot holds a live page
+    bool PageValid(int pageIndex) const;
+    /// test if a page has changed since ClearDirty()
+    bool PageDirty(int pageIndex) const;
+    /// clear the dirty flag of a page after it has been uploaded
+    void ClearDirty(int pageIndex);
+    /// get the CPU-side RGBA8 pixels of a page
+    const uint8* PagePixels(int pageIndex) const;
+    /// size of a page in pixels
+    int PageSize() const;
+    /// size of a page in bytes
+    int PageByteSize() const;
+    /// memory usage of all pages
+    const NKUIStats::MemoryUsage& Usage() const;
+
+private:
+    struct shelf {
+        int y = 0;
+        int height = 0;
+        int x = 0;
+    };
+    struct page {
+        uint8* pixels = nullptr;
+        Array<shelf> shelves;
+        int numEntries = 0;
+        int usedArea = 0;
+        bool dirty = false;
+    };
+    struct entry {
+        int page = InvalidIndex;
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        float uv[4] = { };
+    };
+
+    /// find a spot for a padded rect in a page's shelves, doesn't modify the page
+    bool findSpot(const Array<shelf>& shelves, int w, int h, int& outShelf, int& outX, int& outY) const;
+    /// reserve a spot for a padded rect in a page, returns false if it doesn't fit
+    bool insert(page& p, int w, int h, int& outX, int& outY) const;
+    /// repack a page tallest-first, returns false (and leaves the page untouched) if repacking fails
+    bool compact(int pageIndex);
+    /// copy an image with replicated 1-pixel border into a page
+    void blit(uint8* dst, int x, int y, int w, int h, const uint8* src, int srcPitch) const;
+    /// update the UV rect of an entry from its position
+    void updateUV(entry& e) const;
+    /// allocate a new page, returns InvalidIndex if max number of pages is reached
+    int newPage();
+
+    int pageSize = 0;
+    int maxNumPages = 0;
+    Array<page> pages;
+    Array<entry> entries;
+    Array<int> freeEntries;
+    NKUIStats::MemoryUsage usage;
+};
+
+//------------------------------------------------------------------------------
+inline int
+nkuiImageAtlas::Page(int entryIndex) const {
+    return this->entries[entryIndex].page;
+}
+
+//------------------------------------------------------------------------------
+inline const float*
+nkuiImageAtlas::UVRect(int entryIndex) const {
+    return this->entries[entryIndex].uv;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiImageAtlas::NumPages() const {
+    return this->pages.Size();
+}
+
+//------------------------------------------------------------------------------
+inline bool
+nkuiImageAtlas::PageValid(int pageIndex) const {
+    return nullptr != this->pages[pageIndex].pixels;
+}
+
+//------------------------------------------------------------------------------
+inline bool
+nkuiImageAtlas::PageDirty(int pageIndex) const {
+    return this->pages[pageIndex].dirty;
+}
+
+//------------------------------------------------------------------------------
+inline void
+nkuiImageAtlas::ClearDirty(int pageIndex) {
+    this->pages[pageIndex].dirty = false;
+}
+
+//------------------------------------------------------------------------------
+inline const uint8*
+nkuiImageAtlas::PagePixels(int pageIndex) const {
+    return this->pages[pageIndex].pixels;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiImageAtlas::PageSize() const {
+    return this->pageSize;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiImageAtlas::PageByteSize() const {
+    return this->pageSize * this->pageSize * 4;
+}
+
+//------------------------------------------------------------------------------
+inline const NKUIStats::MemoryUsage&
+nkuiImageAtlas::Usage() const {
+    return this->usage;
+}
+
+} // namespace _priv
+} // namespace Oryol
@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+//  nkuiMemPool.cc
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "nkuiMemPool.h"
+#include "Core/Assertion.h"
+#include "Core/Log.h"
+#include "Core/Memory/Memory.h"
+
+namespace Oryol {
+namespace _priv {
+
+//------------------------------------------------------------------------------
+void
+nkuiMemPool::Setup(const char* name_, int budget) {
+    o_assert_dbg(name_ && (budget >= 0));
+    this->name = name_;
+    this->budgetWarned = false;
+    this->usage = NKUIStats::MemoryUsage();
+    this->usage.BudgetBytes = budget;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiMemPool::Discard() {
+    o_assert_dbg(0 == this->usage.CurrentBytes);
+    this->name = nullptr;
+}
+
+//------------------------------------------------------------------------------
+void*
+nkuiMemPool::Alloc(int numBytes) {
+    o_assert_dbg(numBytes > 0);
+    #if ORYOL_HAS_THREADS
+    std::lock_guard<std::mutex> lock(this->mutex);
+    #endif
+    if ((this->usage.BudgetBytes > 0) && ((this->usage.CurrentBytes + numBytes) > this->usage.BudgetBytes)) {
+        if (!this->budgetWarned) {
+            Log::Warn("NKUI: memory budget of pool '%s' exceeded (%d bytes requested, %d of %d bytes used)\n",
+                this->name, numBytes, this->usage.CurrentBytes, this->usage.BudgetBytes);
+            this->budgetWarned = true;
+        }
+        this->usage.NumBudgetOverruns++;
+    }
+    uint8* ptr = (uint8*) Memory::Alloc(numBytes + HeaderSize);
+    *(int*)ptr = numBytes;
+    this->usage.CurrentBytes += numBytes;
+    if (this->usage.CurrentBytes > this->usage.PeakBytes) {
+        this->usage.PeakBytes = this->usage.CurrentBytes;
+    }
+    this->usage.NumAllocs++;
+    return ptr + HeaderSize;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiMemPool::Free(void* p) {
+    if (p) {
+        uint8* ptr = ((uint8*)p) - HeaderSize;
+        const int numBytes = *(int*)ptr;
+        #if ORYOL_HAS_THREADS
+        std::lock_guard<std::mutex> lock(this->mutex);
+        #endif
+        o_assert_dbg(this->usage.CurrentBytes >= numBytes);
+        this->usage.CurrentBytes -= numBytes;
+        Memory::Free(ptr);
+    }
+}
+
+} // namespace _priv
+} // namespace Oryol
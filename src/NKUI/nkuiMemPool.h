@@ -0,0 +1,53 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::_priv::nkuiMemPool
+    @brief tracking memory pool for nuklear allocations
+
+    Allocates through Oryol's Memory functions, keeps track of current
+    and peak usage. The budget is soft: nuklear asserts on failed
+    allocations, so allocations beyond the budget still succeed, but
+    are counted and logged once. Alloc() and Free() are thread-safe
+    since geometry conversion may run on worker threads.
+*/
+#include "Core/Types.h"
+#include "NKUI/NKUIStats.h"
+#if ORYOL_HAS_THREADS
+#include <mutex>
+#endif
+
+namespace Oryol {
+namespace _priv {
+
+class nkuiMemPool {
+public:
+    /// setup the pool with a name (for warnings) and budget in bytes (0: unlimited)
+    void Setup(const char* name, int budget);
+    /// discard the pool, all memory must have been freed
+    void Discard();
+    /// allocate memory, allocations exceeding the budget are counted in NumBudgetOverruns
+    void* Alloc(int numBytes);
+    /// free memory
+    void Free(void* ptr);
+    /// get current usage
+    const NKUIStats::MemoryUsage& Usage() const;
+
+private:
+    /// size of the allocation header (keeps returned pointers 16-byte aligned)
+    static const int HeaderSize = 16;
+    const char* name = nullptr;
+    bool budgetWarned = false;
+    NKUIStats::MemoryUsage usage;
+    #if ORYOL_HAS_THREADS
+    std::mutex mutex;
+    #endif
+};
+
+//------------------------------------------------------------------------------
+inline const NKUIStats::MemoryUsage&
+nkuiMemPool::Usage() const {
+    return this->usage;
+}
+
+} // namespace _priv
+} // namespace Oryol
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+//  nkuiSDF.cc
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "nkuiSDF.h"
+#include "Core/Assertion.h"
+#include "Core/Memory/Memory.h"
+#include <algorithm>
+#include <math.h>
+
+namespace Oryol {
+namespace _priv {
+
+static const float nkuiSDFInf = 1e20f;
+
+//------------------------------------------------------------------------------
+void
+nkuiSDF::edt1d(const float* f, float* d, int* v, float* z, int n) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -nkuiSDFInf;
+    z[1] = nkuiSDFInf;
+    for (int q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / float(2 * q - 2 * v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / float(2 * q - 2 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = nkuiSDFInf;
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) {
+            k++;
+        }
+        d[q] = float((q - v[k]) * (q - v[k])) + f[v[k]];
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiSDF::edt2d(float* grid, int width, int height) {
+    const int n = std::max(width, height);
+    float* f = (float*) Memory::Alloc(n * sizeof(float));
+    float* d = (float*) Memory::Alloc(n * sizeof(float));
+    float* z = (float*) Memory::Alloc((n + 1) * sizeof(float));
+    int* v = (int*) Memory::Alloc(n * sizeof(int));
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            f[y] = grid[y * width + x];
+        }
+        edt1d(f, d, v, z, height);
+        for (int y = 0; y < height; y++) {
+            grid[y * width + x] = d[y];
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        edt1d(grid + y * width, d, v, z, width);
+        Memory::Copy(d, grid + y * width, width * sizeof(float));
+    }
+    Memory::Free(v);
+    Memory::Free(z);
+    Memory::Free(d);
+    Memory::Free(f);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiSDF::Generate(const uint8* src, int srcWidth, int srcHeight, int oversample, float spread, uint8* dst, int dstPitch) {
+    o_assert_dbg(src && dst && (oversample > 0) && (spread > 0.0f));
+    o_assert_dbg(((srcWidth % oversample) == 0) && ((srcHeight % oversample) == 0));
+
+    // squared distances from outside pixels to the glyph, and from
+    // inside pixels to the background
+    const int num = srcWidth * srcHeight;
+    float* outside = (float*) Memory::Alloc(num * sizeof(float));
+    float* inside = (float*) Memory::Alloc(num * sizeof(float));
+    for (int i = 0; i < num; i++) {
+        const bool in = src[i] >= 128;
+        outside[i] = in ? 0.0f : nkuiSDFInf;
+        inside[i] = in ? nkuiSDFInf : 0.0f;
+    }
+    edt2d(outside, srcWidth, srcHeight);
+    edt2d(inside, srcWidth, srcHeight);
+
+    // sample at destination pixel centers, and map the signed distance
+    // (in destination pixels) to 0..1
+    const int dstWidth = srcWidth / oversample;
+    const int dstHeight = srcHeight / oversample;
+    const float scale = 1.0f / (float(oversample) * 2.0f * spread);
+    for (int y = 0; y < dstHeight; y++) {
+        const int sy = y * oversample + oversample / 2;
+        for (int x = 0; x < dstWidth; x++) {
+            const int sx = x * oversample + oversample / 2;
+            const int i = sy * srcWidth + sx;
+            // distances are between pixel centers, the outline is half a pixel off
+            const float dist = (src[i] >= 128) ? (sqrtf(inside[i]) - 0.5f) : (0.5f - sqrtf(outside[i]));
+            const float val = std::min(std::max(0.5f + dist * scale, 0.0f), 1.0f);
+            dst[y * dstPitch + x] = uint8(val * 255.0f + 0.5f);
+        }
+    }
+    Memory::Free(inside);
+    Memory::Free(outside);
+}
+
+} // namespace _priv
+} // namespace Oryol
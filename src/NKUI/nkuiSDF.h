@@ -0,0 +1,31 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::_priv::nkuiSDF
+    @brief signed distance field generation for SDF glyphs
+
+    Converts an oversampled coverage bitmap into a downsampled
+    single-channel distance field using an exact Euclidean distance
+    transform (Felzenszwalb/Huttenlocher). 0.5 is the glyph outline,
+    values above 0.5 are inside, and the full 0..1 range covers
+    +/- spread destination pixels.
+*/
+#include "Core/Types.h"
+
+namespace Oryol {
+namespace _priv {
+
+class nkuiSDF {
+public:
+    /// generate an SDF, srcWidth/srcHeight must be multiples of oversample
+    static void Generate(const uint8* src, int srcWidth, int srcHeight, int oversample, float spread, uint8* dst, int dstPitch);
+
+private:
+    /// 1D squared distance transform of f into d (v and z are scratch buffers)
+    static void edt1d(const float* f, float* d, int* v, float* z, int n);
+    /// 2D squared distance transform in place
+    static void edt2d(float* grid, int width, int height);
+};
+
+} // namespace _priv
+} // namespace Oryol
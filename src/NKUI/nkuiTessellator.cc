@@ -0,0 +1,72 @@
+//------------------------------------------------------------------------------
+//  nkuiTessellator.cc
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "nkuiTessellator.h"
+#include <algorithm>
+#include <math.h>
+
+namespace Oryol {
+namespace _priv {
+
+static const float nkuiTessPi = 3.14159265358979f;
+
+//------------------------------------------------------------------------------
+void
+nkuiTessellator::Setup(float tolerance_, int maxSegments_) {
+    o_assert_dbg((tolerance_ > 0.0f) && (maxSegments_ >= 4));
+    this->tolerance = tolerance_;
+    this->maxSegments = std::min(maxSegments_, int(TableSize));
+    for (int i = 0; i <= TableSize; i++) {
+        this->cosTable[i] = cosf(float(i) * 2.0f * nkuiTessPi / float(TableSize));
+    }
+
+    // a circle with n segments deviates from the true circle by the
+    // sagitta r * (1 - cos(pi / n)), which gives the max radius per n
+    this->circleSegments.Clear();
+    this->circleMaxRadius.Clear();
+    for (int n = 4; n <= this->maxSegments; n++) {
+        if ((TableSize % n) == 0) {
+            this->circleSegments.Add(n);
+            this->circleMaxRadius.Add(tolerance_ / (1.0f - cosf(nkuiTessPi / float(n))));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiTessellator::CircleSegments(float radius) const {
+    o_assert_dbg(this->IsValid());
+    for (int i = 0; i < this->circleSegments.Size(); i++) {
+        if (radius <= this->circleMaxRadius[i]) {
+            return this->circleSegments[i];
+        }
+    }
+    return this->circleSegments.Back();
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiTessellator::ArcSegments(int circleSegments_, float a0, float a1) const {
+    const float turns = fabsf(a1 - a0) / (2.0f * nkuiTessPi);
+    const int n = int(ceilf(turns * float(circleSegments_)));
+    return std::max(n, 1);
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiTessellator::CurveSegments(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3) const {
+    o_assert_dbg(this->IsValid());
+    // Wang's formula: the max second difference of the control points
+    // bounds the distance between a cubic bezier and its polyline
+    const float dx0 = x0 - 2.0f * x1 + x2;
+    const float dy0 = y0 - 2.0f * y1 + y2;
+    const float dx1 = x1 - 2.0f * x2 + x3;
+    const float dy1 = y1 - 2.0f * y2 + y3;
+    const float m = sqrtf(std::max(dx0 * dx0 + dy0 * dy0, dx1 * dx1 + dy1 * dy1));
+    const int n = int(ceilf(sqrtf(0.75f * m / this->tolerance)));
+    return std::min(std::max(n, 1), this->maxSegments);
+}
+
+} // namespace _priv
+} // namespace Oryol
@@ -0,0 +1,71 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::_priv::nkuiTessellator
+    @brief screen-space adaptive segment counts for circles, arcs and curves
+
+    Picks the number of segments from a shape's size in pixels so that
+    the tessellated outline stays within a tolerance of the true shape.
+    Full circle segment counts are always divisors of TableSize, so that
+    circle and arc points can be looked up in a precomputed sin/cos table
+    instead of calling sinf()/cosf() per point.
+*/
+#include "Core/Types.h"
+#include "Core/Assertion.h"
+#include "Core/Containers/Array.h"
+#include "Core/Containers/StaticArray.h"
+
+namespace Oryol {
+namespace _priv {
+
+class nkuiTessellator {
+public:
+    /// number of entries in the sin/cos table (one full turn)
+    static const int TableSize = 720;
+
+    /// setup with max pixel error and max segments per full circle or curve
+    void Setup(float tolerance, int maxSegments);
+    /// test if the tessellator has been setup
+    bool IsValid() const;
+    /// number of segments of a full circle, a divisor of TableSize
+    int CircleSegments(float radius) const;
+    /// number of segments of an arc from angle a0 to a1 in steps of a full circle's segments
+    int ArcSegments(int circleSegments, float a0, float a1) const;
+    /// number of segments of a cubic bezier curve
+    int CurveSegments(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3) const;
+    /// cos(i * 2pi / TableSize), i in 0..TableSize
+    float Cos(int i) const;
+    /// sin(i * 2pi / TableSize), i in 0..TableSize
+    float Sin(int i) const;
+
+private:
+    float tolerance = 0.0f;
+    int maxSegments = 0;
+    /// candidate circle segment counts (ascending), and the max radius each one is good for
+    Array<int> circleSegments;
+    Array<float> circleMaxRadius;
+    StaticArray<float, TableSize + 1> cosTable;
+};
+
+//------------------------------------------------------------------------------
+inline bool
+nkuiTessellator::IsValid() const {
+    return this->maxSegments > 0;
+}
+
+//------------------------------------------------------------------------------
+inline float
+nkuiTessellator::Cos(int i) const {
+    return this->cosTable[i];
+}
+
+//------------------------------------------------------------------------------
+inline float
+nkuiTessellator::Sin(int i) const {
+    // sin(x) = cos(x - pi/2)
+    const int j = i - TableSize / 4;
+    return this->cosTable[j < 0 ? j + TableSize : j];
+}
+
+} // namespace _priv
+} // namespace Oryol
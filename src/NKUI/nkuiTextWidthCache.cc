@@ -0,0 +1,169 @@
+//------------------------------------------------------------------------------
+//  nkuiTextWidthCache.cc
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "nkuiTextWidthCache.h"
+#include "Core/Assertion.h"
+#include "Core/Memory/Memory.h"
+#include <string.h>
+
+namespace Oryol {
+namespace _priv {
+
+//------------------------------------------------------------------------------
+void
+nkuiTextWidthCache::Setup(int maxEntries_) {
+    o_assert_dbg(!this->IsValid());
+    o_assert_dbg(maxEntries_ > 0);
+    // keep the table at most half full so that probe sequences stay short
+    int tableSize = 16;
+    while (tableSize < (maxEntries_ * 2)) {
+        tableSize *= 2;
+    }
+    this->maxEntries = maxEntries_;
+    this->mask = uint32(tableSize - 1);
+    this->entries = (entry*) Memory::Alloc(tableSize * int(sizeof(entry)));
+    this->spareEntries = (entry*) Memory::Alloc(tableSize * int(sizeof(entry)));
+    for (int i = 0; i < tableSize; i++) {
+        this->entries[i] = entry();
+    }
+    // room for the average UI label
+    this->textBufferSize = maxEntries_ * 24;
+    this->textBuffer = (char*) Memory::Alloc(this->textBufferSize);
+    this->spareTextBuffer = (char*) Memory::Alloc(this->textBufferSize);
+    this->textBufferPos = 0;
+    this->frame = 1;
+    this->full = false;
+    this->numEntries = 0;
+    this->numEvictions = 0;
+    this->numHits = 0;
+    this->numMisses = 0;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiTextWidthCache::Discard() {
+    o_assert_dbg(this->IsValid());
+    Memory::Free(this->entries);
+    this->entries = nullptr;
+    Memory::Free(this->spareEntries);
+    this->spareEntries = nullptr;
+    Memory::Free(this->textBuffer);
+    this->textBuffer = nullptr;
+    Memory::Free(this->spareTextBuffer);
+    this->spareTextBuffer = nullptr;
+}
+
+//------------------------------------------------------------------------------
+uint32
+nkuiTextWidthCache::Hash(float height, const char* text, int len) {
+    // FNV-1a over the height bits and the text
+    uint32 hash = 2166136261u;
+    const uint8* bytes = (const uint8*) &height;
+    for (int i = 0; i < int(sizeof(height)); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    for (int i = 0; i < len; i++) {
+        hash = (hash ^ uint8(text[i])) * 16777619u;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiTextWidthCache::findSlot(uint32 hash, float height, const char* text, int len) const {
+    uint32 index = hash & this->mask;
+    while (this->entries[index].used) {
+        const entry& e = this->entries[index];
+        if ((e.hash == hash) && (e.height == height) && (e.textLen == len) &&
+            (0 == memcmp(this->textBuffer + e.textOffset, text, len))) {
+            break;
+        }
+        index = (index + 1) & this->mask;
+    }
+    return int(index);
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiTextWidthCache::Lookup(uint32 hash, float height, const char* text, int len, float& outWidth) {
+    o_assert_dbg(this->IsValid());
+    if (len <= MaxTextLength) {
+        entry& e = this->entries[this->findSlot(hash, height, text, len)];
+        if (e.used) {
+            e.lastUsed = this->frame;
+            outWidth = e.width;
+            this->numHits++;
+            return true;
+        }
+    }
+    this->numMisses++;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiTextWidthCache::Insert(uint32 hash, float height, const char* text, int len, float width) {
+    o_assert_dbg(this->IsValid());
+    if ((len > MaxTextLength) || (len < 0)) {
+        return;
+    }
+    if ((this->numEntries >= this->maxEntries) || ((this->textBufferPos + len) > this->textBufferSize)) {
+        // make room in the next NewFrame()
+        this->full = true;
+        return;
+    }
+    entry& e = this->entries[this->findSlot(hash, height, text, len)];
+    o_assert_dbg(!e.used);
+    e.hash = hash;
+    e.lastUsed = this->frame;
+    e.height = height;
+    e.width = width;
+    e.textOffset = this->textBufferPos;
+    e.textLen = len;
+    e.used = true;
+    Memory::Copy(text, this->textBuffer + this->textBufferPos, len);
+    this->textBufferPos += len;
+    this->numEntries++;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiTextWidthCache::NewFrame() {
+    o_assert_dbg(this->IsValid());
+    if (this->full) {
+        this->evict();
+        this->full = false;
+    }
+    this->frame++;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiTextWidthCache::evict() {
+    // swap in the spare table and text buffer, and re-insert
+    // what was used in the last frame
+    const int tableSize = int(this->mask + 1);
+    entry* oldEntries = this->entries;
+    char* oldText = this->textBuffer;
+    this->entries = this->spareEntries;
+    this->textBuffer = this->spareTextBuffer;
+    this->spareEntries = oldEntries;
+    this->spareTextBuffer = oldText;
+    for (int i = 0; i < tableSize; i++) {
+        this->entries[i] = entry();
+    }
+    this->textBufferPos = 0;
+    const int numOldEntries = this->numEntries;
+    this->numEntries = 0;
+    for (int i = 0; i < tableSize; i++) {
+        const entry& e = oldEntries[i];
+        if (e.used && (e.lastUsed == this->frame)) {
+            this->Insert(e.hash, e.height, oldText + e.textOffset, e.textLen, e.width);
+        }
+    }
+    this->numEvictions += numOldEntries - this->numEntries;
+}
+
+} // namespace _priv
+} // namespace Oryol
@@ -0,0 +1,127 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::_priv::nkuiTextWidthCache
+    @brief per-font cache of measured text widths
+
+    Maps (height, text) to the width returned by a font's width callback.
+    The table uses open addressing with linear probing, the cached strings
+    are copied into a fixed-size text buffer, so that lookups compare the
+    actual text and always return the same width as the uncached callback.
+    Texts longer than MaxTextLength are never cached.
+
+    When the table or the text buffer fills up, NewFrame() rebuilds the
+    cache with only the entries used in the previous frame (the least
+    recently used entries are evicted). The rebuild goes into a second
+    table and text buffer allocated in Setup(), which are then swapped
+    with the current ones, so the cache never allocates after Setup().
+
+    The cache isn't thread-safe, text widths are only measured by
+    the UI code between NKUI::NewFrame() and NKUI::Draw().
+*/
+#include "Core/Types.h"
+
+namespace Oryol {
+namespace _priv {
+
+class nkuiTextWidthCache {
+public:
+    /// longest cached text in bytes
+    static const int MaxTextLength = 64;
+
+    /// setup with max number of cached text widths
+    void Setup(int maxEntries);
+    /// discard the cache
+    void Discard();
+    /// test if the cache has been setup
+    bool IsValid() const;
+    /// start a new frame, evicts entries not used in the last frame if the cache is full
+    void NewFrame();
+    /// compute the lookup hash of a text
+    static uint32 Hash(float height, const char* text, int len);
+    /// lookup a text width, returns false if not cached
+    bool Lookup(uint32 hash, float height, const char* text, int len, float& outWidth);
+    /// insert the width of a text after Lookup() failed
+    void Insert(uint32 hash, float height, const char* text, int len, float width);
+
+    /// number of cached text widths
+    int NumEntries() const;
+    /// number of evicted text widths since setup
+    int NumEvictions() const;
+    /// number of successful lookups since ResetCounters()
+    int NumHits() const;
+    /// number of failed lookups since ResetCounters()
+    int NumMisses() const;
+    /// reset the hit and miss counters
+    void ResetCounters();
+
+private:
+    struct entry {
+        uint32 hash = 0;
+        uint32 lastUsed = 0;
+        float height = 0.0f;
+        float width = 0.0f;
+        int textOffset = 0;
+        int textLen = 0;
+        bool used = false;
+    };
+    /// find the slot of a text, or the free slot where it would go
+    int findSlot(uint32 hash, float height, const char* text, int len) const;
+    /// rebuild the table with the entries used in the last frame
+    void evict();
+
+    entry* entries = nullptr;
+    entry* spareEntries = nullptr;
+    uint32 mask = 0;
+    int maxEntries = 0;
+    char* textBuffer = nullptr;
+    char* spareTextBuffer = nullptr;
+    int textBufferSize = 0;
+    int textBufferPos = 0;
+    uint32 frame = 1;
+    bool full = false;
+    int numEntries = 0;
+    int numEvictions = 0;
+    int numHits = 0;
+    int numMisses = 0;
+};
+
+//------------------------------------------------------------------------------
+inline bool
+nkuiTextWidthCache::IsValid() const {
+    return nullptr != this->entries;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiTextWidthCache::NumEntries() const {
+    return this->numEntries;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiTextWidthCache::NumEvictions() const {
+    return this->numEvictions;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiTextWidthCache::NumHits() const {
+    return this->numHits;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiTextWidthCache::NumMisses() const {
+    return this->numMisses;
+}
+
+//------------------------------------------------------------------------------
+inline void
+nkuiTextWidthCache::ResetCounters() {
+    this->numHits = 0;
+    this->numMisses = 0;
+}
+
+} // namespace _priv
+} // namespace Oryol
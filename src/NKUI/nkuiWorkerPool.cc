@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+//  nkuiWorkerPool.cc
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "nkuiWorkerPool.h"
+#include "Core/Assertion.h"
+
+namespace Oryol {
+namespace _priv {
+
+//------------------------------------------------------------------------------
+void
+nkuiWorkerPool::Setup(int num) {
+    o_assert_dbg((0 == this->numThreads) && (num >= 0));
+    #if ORYOL_HAS_THREADS
+    this->numThreads = num < MaxNumThreads ? num : MaxNumThreads;
+    this->quit = false;
+    for (int i = 0; i < this->numThreads; i++) {
+        this->threads[i] = std::thread(&nkuiWorkerPool::workerLoop, this, i + 1);
+    }
+    #endif
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWorkerPool::Discard() {
+    #if ORYOL_HAS_THREADS
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->quit = true;
+    }
+    this->wakeCond.notify_all();
+    for (int i = 0; i < this->numThreads; i++) {
+        this->threads[i].join();
+    }
+    #endif
+    this->numThreads = 0;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWorkerPool::Run(const std::function<void(int)>& func) {
+    #if ORYOL_HAS_THREADS
+    if (this->numThreads > 0) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->job = &func;
+            this->pending = this->numThreads;
+            this->generation++;
+        }
+        this->wakeCond.notify_all();
+        func(0);
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->doneCond.wait(lock, [this] { return 0 == this->pending; });
+        this->job = nullptr;
+        return;
+    }
+    #endif
+    func(0);
+}
+
+#if ORYOL_HAS_THREADS
+//------------------------------------------------------------------------------
+void
+nkuiWorkerPool::workerLoop(int workerIndex) {
+    int lastGeneration = 0;
+    for (;;) {
+        const std::function<void(int)>* func = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wakeCond.wait(lock, [this, lastGeneration] {
+                return this->quit || (this->generation != lastGeneration);
+            });
+            if (this->quit) {
+                return;
+            }
+            lastGeneration = this->generation;
+            func = this->job;
+        }
+        (*func)(workerIndex);
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (0 == --this->pending) {
+                this->doneCond.notify_one();
+            }
+        }
+    }
+}
+#endif
+
+} // namespace _priv
+} // namespace Oryol
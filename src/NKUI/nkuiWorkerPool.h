@@ -0,0 +1,62 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Oryol::_priv::nkuiWorkerPool
+    @brief minimal fork/join thread pool for parallel geometry conversion
+
+    Run() executes a job function on every worker thread and on the
+    calling thread (with worker index 0), and returns when all
+    of them are done. Without ORYOL_HAS_THREADS, no threads are
+    created and Run() simply calls the job on the calling thread.
+*/
+#include "Core/Types.h"
+#include "Core/Containers/StaticArray.h"
+#include <functional>
+#if ORYOL_HAS_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace Oryol {
+namespace _priv {
+
+class nkuiWorkerPool {
+public:
+    /// max number of worker threads
+    static const int MaxNumThreads = 16;
+
+    /// start worker threads
+    void Setup(int numThreads);
+    /// stop worker threads
+    void Discard();
+    /// number of worker threads (not counting the calling thread)
+    int NumThreads() const;
+    /// run job on all workers and the calling thread, job arg is worker index
+    void Run(const std::function<void(int)>& job);
+
+private:
+    int numThreads = 0;
+    #if ORYOL_HAS_THREADS
+    /// worker thread loop
+    void workerLoop(int workerIndex);
+
+    StaticArray<std::thread, MaxNumThreads> threads;
+    std::mutex mutex;
+    std::condition_variable wakeCond;
+    std::condition_variable doneCond;
+    const std::function<void(int)>* job = nullptr;
+    int generation = 0;
+    int pending = 0;
+    bool quit = false;
+    #endif
+};
+
+//------------------------------------------------------------------------------
+inline int
+nkuiWorkerPool::NumThreads() const {
+    return this->numThreads;
+}
+
+} // namespace _priv
+} // namespace Oryol
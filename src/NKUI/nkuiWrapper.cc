@@ -5,14 +5,148 @@
 #define NK_IMPLEMENTATION
 #include "nkuiWrapper.h"
 #include "Core/Memory/Memory.h"
+#include "Core/Log.h"
 #include "Input/Input.h"
+#include "Core/Time/Clock.h"
 #include "NKUIShaders.h"
+#include "nkuiSDF.h"
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include <string.h>
+#include <algorithm>
+#include <math.h>
 
 namespace Oryol {
 namespace _priv {
 
+//------------------------------------------------------------------------------
+static void*
+nkuiAlloc(nk_handle userdata, void* /*old*/, nk_size size) {
+    return ((nkuiMemPool*)userdata.ptr)->Alloc(int(size));
+}
+
+//------------------------------------------------------------------------------
+static void
+nkuiFree(nk_handle userdata, void* ptr) {
+    ((nkuiMemPool*)userdata.ptr)->Free(ptr);
+}
+
+//------------------------------------------------------------------------------
+static struct nk_allocator
+nkuiAllocator(nkuiMemPool* pool) {
+    struct nk_allocator alloc;
+    alloc.userdata = nk_handle_ptr(pool);
+    alloc.alloc = nkuiAlloc;
+    alloc.free = nkuiFree;
+    return alloc;
+}
+
+//------------------------------------------------------------------------------
+//  Baked font atlas cache blob layout:
+//
+//  - nkuiFontCacheHeader
+//  - nkuiFontCacheFont[numFonts]
+//  - nk_font_glyph[numGlyphs]
+//  - atlas pixels (texWidth * texHeight * bytes per pixel)
+//
+//  The blob isn't portable between platforms, but the key includes
+//  the sizes of the nuklear structs which end up in the blob.
+//
+static const uint32 nkuiFontCacheMagic = 0x41464B4E; // "NKFA"
+static const uint32 nkuiFontCacheVersion = 1;
+
+struct nkuiFontCacheHeader {
+    uint32 magic;
+    uint32 version;
+    uint64 key;
+    int32 format;
+    int32 texWidth;
+    int32 texHeight;
+    int32 numFonts;
+    int32 numGlyphs;
+    struct nk_recti custom;
+    struct nk_cursor cursors[NK_CURSOR_COUNT];
+};
+
+struct nkuiFontCacheFont {
+    float height;
+    float ascent;
+    float descent;
+    nk_rune glyphOffset;
+    nk_rune glyphCount;
+};
+
+//------------------------------------------------------------------------------
+//  Capture blob layout:
+//
+//  - nkuiCaptureHeader
+//  - per frame:
+//      - nkuiCaptureFrame
+//      - nk_rune[numRunes] (text input)
+//      - int32[numSegmentStarts] (window command list offsets)
+//      - nuklear command memory[cmdSize]
+//
+//  Idle frames have no segment starts and commands, and commands are
+//  only stored if they changed since the previous frame. Font pointers
+//  in text commands are replaced with font indices (in order of
+//  creation, 0 is the default font), and custom commands with nops.
+//  The blob isn't portable between platforms, since the nuklear
+//  commands contain pointer-sized fields.
+//
+static const uint32 nkuiCaptureMagic = 0x50434B4E; // "NKCP"
+static const uint32 nkuiCaptureFrameMagic = 0x46434B4E; // "NKCF"
+static const uint32 nkuiCaptureVersion = 1;
+static const uint32 nkuiCaptureIdle = 1<<0;
+static const uint32 nkuiCaptureSameCmds = 1<<1;
+
+struct nkuiCaptureHeader {
+    uint32 magic;
+    uint32 version;
+    int32 pointerSize;
+    int32 commandSize;
+};
+
+struct nkuiCaptureFrame {
+    uint32 magic;
+    uint32 flags;
+    int32 fbWidth;
+    int32 fbHeight;
+    uint32 inputFlags;
+    uint32 keys;
+    int32 mouseX;
+    int32 mouseY;
+    float scrollX;
+    float scrollY;
+    int32 numRunes;
+    int32 numSegmentStarts;
+    int32 cmdBegin;
+    int32 cmdSize;
+};
+
+//------------------------------------------------------------------------------
+static uint64
+nkuiHash(uint64 hash, const void* data, int size) {
+    // FNV-1a
+    const uint8* ptr = (const uint8*) data;
+    for (int i = 0; i < size; i++) {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+template<class TYPE> static uint64
+nkuiHashValue(uint64 hash, const TYPE& val) {
+    return nkuiHash(hash, &val, int(sizeof(val)));
+}
+
+//------------------------------------------------------------------------------
+static int
+nkuiFontAtlasBytesPerPixel(enum nk_font_atlas_format format) {
+    return (NK_FONT_ATLAS_ALPHA8 == format) ? 1 : 4;
+}
+
 //------------------------------------------------------------------------------
 void
 nkuiWrapper::Setup(const NKUISetup& setup) {
@@ -26,6 +160,53 @@ nkuiWrapper::Setup(const NKUISetup& setup) {
     this->config.circle_segment_count = setup.CircleSegmentCount;
     this->config.curve_segment_count = setup.CurveSegmentCount;
     this->config.arc_segment_count = setup.ArcSegmentCount;
+    this->adaptiveTessellation = setup.AdaptiveTessellation;
+    if (this->adaptiveTessellation) {
+        this->tessellator.Setup(setup.TessellationTolerance, setup.MaxSegmentCount);
+    }
+    this->retainedMode = setup.RetainedMode;
+    o_assert_dbg(setup.IdleSettleFrames > 0);
+    this->idleFrames = setup.IdleFrames;
+    this->idleSettleFrames = setup.IdleSettleFrames;
+    this->numUpdateFrames = 0;
+    this->needsUpdate = true;
+    this->updateRequested = false;
+    this->headless = setup.Headless;
+    this->alphaFontAtlas = setup.AlphaFontAtlas;
+    this->glyphCacheSize = setup.GlyphCacheSize;
+    o_assert_dbg(!setup.TextWidthCache || (setup.TextWidthCacheSize > 0));
+    this->textWidthCacheSize = setup.TextWidthCache ? setup.TextWidthCacheSize : 0;
+    this->glyphCacheImages.Fill(0);
+    this->sdfSpread = setup.SDFSpread;
+    this->headlessWidth = setup.HeadlessWidth;
+    this->headlessHeight = setup.HeadlessHeight;
+    o_assert_dbg(!setup.Offscreen || ((setup.OffscreenWidth > 0) && (setup.OffscreenHeight > 0)));
+    this->offscreen = setup.Offscreen;
+    this->offscreenWidth = setup.OffscreenWidth;
+    this->offscreenHeight = setup.OffscreenHeight;
+    this->offscreenValid = false;
+    this->compositeRect[0] = 0.0f;
+    this->compositeRect[1] = 0.0f;
+    this->compositeRect[2] = float(setup.OffscreenWidth);
+    this->compositeRect[3] = float(setup.OffscreenHeight);
+    o_assert_dbg(setup.FrameStatsWindowSize > 0);
+    this->frameStatsWindowSize = setup.FrameStatsWindowSize;
+    this->frameStatsHistory.Reserve(this->frameStatsWindowSize);
+    o_assert_dbg((setup.ChunkNumVertices > 0) && (setup.ChunkNumIndices > 0) && (setup.MaxNumChunks > 0));
+    this->chunkNumVertices = std::min(setup.ChunkNumVertices, int(MaxChunkVertices));
+    this->chunkNumIndices = setup.ChunkNumIndices;
+    this->maxNumChunks = setup.MaxNumChunks;
+    o_assert_dbg(setup.NumGeometryBuffers > 0);
+    this->numGeomBuffers = setup.NumGeometryBuffers;
+    this->curGeomBuffer = InvalidIndex;
+    o_assert_dbg(!setup.InstancedQuads || ((setup.ChunkNumInstances > 0) && (setup.MaxNumInstChunks > 0)));
+    this->instancedQuads = setup.InstancedQuads;
+    this->chunkNumInstances = setup.ChunkNumInstances;
+    this->maxNumInstChunks = setup.MaxNumInstChunks;
+    this->compactVertices = setup.CompactVertices;
+    if (this->compactVertices) {
+        this->packedVertices = (nkui_compact_vertex*) Memory::Alloc(this->chunkNumVertices * sizeof(nkui_compact_vertex));
+    }
     
     static const struct nk_draw_vertex_layout_element vertex_layout[] = {
         {NK_VERTEX_POSITION, NK_FORMAT_FLOAT, NK_OFFSETOF(struct nkui_draw_vertex, position)},
@@ -37,17 +218,59 @@ nkuiWrapper::Setup(const NKUISetup& setup) {
     this->config.vertex_size = sizeof(struct nkui_draw_vertex);
     this->config.vertex_alignment = NK_ALIGNOF(struct nkui_draw_vertex);
 
-    this->freeImageSlots.Reserve(MaxImages);
-    for (int i = MaxImages-1; i>=0; i--) {
-        this->freeImageSlots.Add(i);
+    // the image table grows on demand, freed slots are recycled
+    this->images.Reserve(setup.InitialNumImages);
+    this->freeImageSlots.Reserve(setup.InitialNumImages);
+
+    // all nuklear memory comes from tracking memory pools, the context
+    // pool grows on demand, the other pools have soft budgets
+    this->ctxPool.Setup("context", 0);
+    this->cmdPool.Setup("commands", setup.CommandMemoryBudget);
+    this->geomPool.Setup("geometry", setup.GeometryMemoryBudget);
+    this->atlasPool.Setup("font atlas", setup.FontAtlasMemoryBudget);
+    if (setup.ImageAtlas) {
+        this->imageAtlas.Setup(setup.ImageAtlasPageSize, setup.ImageAtlasMaxNumPages);
+        this->imageAtlasMaxImageSize = setup.ImageAtlasMaxImageSize;
     }
+    this->ctxAlloc = nkuiAllocator(&this->ctxPool);
+    this->cmdAlloc = nkuiAllocator(&this->cmdPool);
+    this->geomAlloc = nkuiAllocator(&this->geomPool);
+    this->atlasAlloc = nkuiAllocator(&this->atlasPool);
 
     this->createResources(setup);
 
-    nk_init_default(&this->ctx, &this->defaultFont->handle);
-    nk_buffer_init_default(&this->cmds);
-    nk_buffer_init_fixed(&vbuf, this->vertexData, sizeof(this->vertexData));
-    nk_buffer_init_fixed(&ibuf, this->indexData, sizeof(this->indexData));
+    // the nuklear context either grows on demand (commands in a growing
+    // buffer, window state in a page pool), or works on a single fixed
+    // memory block which drops commands once it is full
+    o_assert_dbg(setup.ContextMemorySize >= 0);
+    this->stats.ContextMemory = NKUIStats::MemoryUsage();
+    this->ctxOverflowWarned = false;
+    if (setup.ContextMemorySize > 0) {
+        this->ctxMemory = Memory::Alloc(setup.ContextMemorySize);
+        this->stats.ContextMemory.BudgetBytes = setup.ContextMemorySize;
+        this->stats.ContextMemory.NumAllocs = 1;
+        nk_init_fixed(&this->ctx, this->ctxMemory, setup.ContextMemorySize, &this->defaultFont->handle);
+    }
+    else {
+        nk_init(&this->ctx, &this->ctxAlloc, &this->defaultFont->handle);
+    }
+
+    // vertex- and index-buffers grow on demand
+    this->initConvertBuffers(this->buffers, setup.InitialNumVertices, setup.InitialNumIndices);
+    nk_buffer_init(&this->instData, &this->geomAlloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+
+    // optional worker threads for parallel geometry conversion, each
+    // worker (including the main thread) converts into its own buffers
+    if (setup.NumConvertThreads > 0) {
+        this->workerPool.Setup(setup.NumConvertThreads);
+        const int numWorkers = this->workerPool.NumThreads() + 1;
+        this->workerBuffers.Reserve(numWorkers);
+        for (int i = 0; i < numWorkers; i++) {
+            this->workerBuffers.Add(convertBuffers());
+            this->initConvertBuffers(this->workerBuffers.Back(), setup.InitialNumVertices / numWorkers, setup.InitialNumIndices / numWorkers);
+        }
+    }
+    this->updateMemoryStats();
 }
 
 //------------------------------------------------------------------------------
@@ -55,18 +278,122 @@ void
 nkuiWrapper::Discard() {
     o_assert_dbg(this->isValid);
     this->defaultFont = nullptr;
-    nk_buffer_free(&this->cmds);
+    this->drawCmds.Clear();
+    this->chunks.Clear();
+    this->chunkMeshes.Clear();
+    this->curGeomBuffer = InvalidIndex;
+    this->instChunks.Clear();
+    this->instMeshes.Clear();
+    this->quadMesh.Invalidate();
+    this->prevCmdStream.Clear();
+    this->EndCapture();
+    this->replayCmds.Clear();
+    this->cmds = cmdStream();
+    this->userFonts.Clear();
+    this->geomValid = false;
+    this->workerPool.Discard();
+    for (convertBuffers& bufs : this->workerBuffers) {
+        this->freeConvertBuffers(bufs);
+    }
+    this->workerBuffers.Clear();
+    this->segments.Clear();
+    this->numSegments = 0;
+    this->freeConvertBuffers(this->buffers);
+    nk_buffer_free(&this->instData);
+    if (this->packedVertices) {
+        Memory::Free(this->packedVertices);
+        this->packedVertices = nullptr;
+    }
     nk_font_atlas_clear(&this->defaultAtlas);
+    for (int i = 0; i < this->curFontAtlas; i++) {
+        nk_font_atlas_clear(&this->fontAtlases[i]);
+    }
+    this->curFontAtlas = 0;
     nk_free(&this->ctx);
-    Gfx::DestroyResources(this->gfxResLabel);
+    if (this->ctxMemory) {
+        Memory::Free(this->ctxMemory);
+        this->ctxMemory = nullptr;
+    }
+    this->ctxPool.Discard();
+    this->cmdPool.Discard();
+    this->geomPool.Discard();
+    this->atlasPool.Discard();
+    if (!this->headless) {
+        Gfx::DestroyResources(this->gfxResLabel);
+    }
+    for (const imageEntry& entry : this->images) {
+        if (entry.label.IsValid()) {
+            Gfx::DestroyResources(entry.label);
+        }
+    }
+    this->images.Clear();
+    this->freeImageSlots.Clear();
+    this->imageAtlas.Discard();
+    this->imageAtlasMaxImageSize = 0;
+    for (dynamicFont* font : this->dynamicFonts) {
+        Memory::Delete(font);
+    }
+    this->dynamicFonts.Clear();
+    for (cachedFont* font : this->cachedFonts) {
+        Memory::Delete(font);
+    }
+    this->cachedFonts.Clear();
+    for (nkuiGlyphCache& cache : this->glyphCaches) {
+        if (cache.IsValid()) {
+            cache.Discard();
+        }
+    }
+    this->glyphCacheImages.Fill(0);
+    this->atlasPageImages.Clear();
+    this->stats.NumImages = 0;
+    this->rgbaPipeline.Invalidate();
+    this->alphaPipeline.Invalidate();
+    this->sdfPipeline.Invalidate();
+    this->instRgbaPipeline.Invalidate();
+    this->instAlphaPipeline.Invalidate();
+    this->instSdfPipeline.Invalidate();
+    this->offscreenTexture.Invalidate();
+    this->offscreenPass.Invalidate();
+    this->compositePipeline.Invalidate();
+    this->compositeMesh.Invalidate();
+    this->offscreenValid = false;
     this->isValid = false;
 }
 
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::initConvertBuffers(convertBuffers& bufs, int numVertices, int numIndices) {
+    nk_buffer_init(&bufs.cmds, &this->cmdAlloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+    nk_buffer_init(&bufs.vbuf, &this->geomAlloc, std::max(numVertices, 1) * sizeof(struct nkui_draw_vertex));
+    nk_buffer_init(&bufs.ibuf, &this->geomAlloc, std::max(numIndices, 1) * sizeof(nk_draw_index));
+    nk_buffer_init(&bufs.inst, &this->geomAlloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::freeConvertBuffers(convertBuffers& bufs) {
+    nk_buffer_free(&bufs.cmds);
+    nk_buffer_free(&bufs.vbuf);
+    nk_buffer_free(&bufs.ibuf);
+    nk_buffer_free(&bufs.inst);
+}
+
 //------------------------------------------------------------------------------
 void
 nkuiWrapper::createResources(const NKUISetup& setup) {
     o_assert_dbg(nullptr == this->defaultFont);
 
+    // render default font, this also happens in headless mode
+    // where the nuklear font atlas is needed but no texture is created
+    nk_font_atlas_init(&this->defaultAtlas, &this->atlasAlloc);
+    nk_font_atlas_begin(&this->defaultAtlas);
+    this->defaultFont = nk_font_atlas_add_default(&this->defaultAtlas, setup.DefaultFontHeight, 0);
+    this->userFonts.Add(&this->defaultFont->handle);
+    if (this->headless) {
+        this->endFontAtlas(&this->defaultAtlas, setup.DefaultFontAtlasCache);
+        return;
+    }
+
     // push a new resource label and store it (needed to destroy resources later)
     this->gfxResLabel = Gfx::PushResourceLabel();
 
@@ -86,79 +413,404 @@ nkuiWrapper::createResources(const NKUISetup& setup) {
     texSetup.ImageData.Sizes[0][0] = sizeof(pixels);
     this->whiteTexture = Gfx::CreateResource(texSetup, pixels, sizeof(pixels));
 
-    // render default font into an Oryol texture
-    nk_font_atlas_init_default(&this->defaultAtlas);
-    nk_font_atlas_begin(&this->defaultAtlas);
-    this->defaultFont = nk_font_atlas_add_default(&this->defaultAtlas, setup.DefaultFontHeight, 0);
-    int imgWidth, imgHeight;
-    const void* imgData = nk_font_atlas_bake(&this->defaultAtlas, &imgWidth, &imgHeight, NK_FONT_ATLAS_RGBA32);
-    texSetup = TextureSetup::FromPixelData2D(imgWidth, imgHeight, 1, PixelFormat::RGBA8);
-    texSetup.Sampler.WrapU = TextureWrapMode::ClampToEdge;
-    texSetup.Sampler.WrapV = TextureWrapMode::ClampToEdge;
-    texSetup.Sampler.MinFilter = TextureFilterMode::Nearest;
-    texSetup.Sampler.MagFilter = TextureFilterMode::Nearest;
-    const int imgSize = imgWidth*imgHeight * PixelFormat::ByteSize(PixelFormat::RGBA8);
-    texSetup.ImageData.Sizes[0][0] = imgSize;
-    struct nk_image img = this->AllocImage();
-    this->BindImage(img, Gfx::CreateResource(texSetup, imgData, imgSize));    
-    nk_font_atlas_end(&this->defaultAtlas, img.handle, &this->config.null);
+    // create an Oryol texture for the default font
+    this->endFontAtlas(&this->defaultAtlas, setup.DefaultFontAtlasCache);
 
-    // create mesh with dynamic vertex- and index-buffer
-    auto mshSetup = MeshSetup::Empty(MaxNumVertices, Usage::Stream, IndexType::Index16, MaxNumIndices, Usage::Stream);
-    mshSetup.Layout
+    // create the mesh for the first geometry chunk, more are created on demand
+    this->meshLayout
         .Add(VertexAttr::Position, VertexFormat::Float2)
         .Add(VertexAttr::TexCoord0, VertexFormat::Float2)
         .Add(VertexAttr::Color0, VertexFormat::UByte4N);
-    o_assert_dbg(mshSetup.Layout.ByteSize() == sizeof(struct nkui_draw_vertex));
-    this->drawState.Mesh[0] = Gfx::CreateResource(mshSetup);
+    o_assert_dbg(this->meshLayout.ByteSize() == sizeof(struct nkui_draw_vertex));
+    if (this->compactVertices) {
+        this->compactLayout
+            .Add(VertexAttr::Position, VertexFormat::Short2)
+            .Add(VertexAttr::TexCoord0, VertexFormat::Short2N)
+            .Add(VertexAttr::Color0, VertexFormat::UByte4N);
+        o_assert_dbg(this->compactLayout.ByteSize() == sizeof(struct nkui_compact_vertex));
+    }
+    for (int i = 0; i < this->numGeomBuffers; i++) {
+        this->chunkMeshes.Add(this->createChunkMesh());
+    }
+    this->drawState.Mesh[0] = this->chunkMeshes[0];
+
+    // create pipeline state objects, a separate pipeline samples
+    // alpha-only font atlas and glyph cache textures as coverage,
+    // compact vertices are scaled back to pixels in the vertex shader
+    if (this->compactVertices) {
+        this->rgbaPipeline = this->createPipeline(NKUICompactShader::Setup());
+        this->alphaPipeline = this->createPipeline(NKUICompactAlphaShader::Setup());
+        this->sdfPipeline = this->createPipeline(NKUICompactSDFShader::Setup());
+    }
+    else {
+        this->rgbaPipeline = this->createPipeline(NKUIShader::Setup());
+        this->alphaPipeline = this->createPipeline(NKUIAlphaShader::Setup());
+        this->sdfPipeline = this->createPipeline(NKUISDFShader::Setup());
+    }
+    this->drawState.Pipeline = this->rgbaPipeline;
+
+    // the instanced quad renderer draws a unit quad triangle strip
+    // once per nkui_instance record
+    if (this->instancedQuads) {
+        this->quadLayout.Add(VertexAttr::Position, VertexFormat::Float2);
+        this->instLayout
+            .EnableInstancing()
+            .Add(VertexAttr::Instance0, VertexFormat::Short4)
+            .Add(VertexAttr::Instance1, VertexFormat::Short4N)
+            .Add(VertexAttr::Instance2, VertexFormat::UByte4N)
+            .Add(VertexAttr::Instance3, VertexFormat::UByte4);
+        o_assert_dbg(this->instLayout.ByteSize() == sizeof(struct nkui_instance));
+        const float corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+        auto quadSetup = MeshSetup::FromData();
+        quadSetup.NumVertices = 4;
+        quadSetup.IndicesType = IndexType::None;
+        quadSetup.Layout = this->quadLayout;
+        quadSetup.AddPrimitiveGroup(PrimitiveGroup(0, 4));
+        this->quadMesh = Gfx::CreateResource(quadSetup, corners, sizeof(corners));
+        this->instRgbaPipeline = this->createPipeline(NKUIInstShader::Setup(), true);
+        this->instAlphaPipeline = this->createPipeline(NKUIInstAlphaShader::Setup(), true);
+        this->instSdfPipeline = this->createPipeline(NKUIInstSDFShader::Setup(), true);
+    }
+    if (this->offscreen) {
+        this->createOffscreenResources();
+    }
 
-    // create pipeline state object
+    Gfx::PopResourceLabel();
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::createOffscreenResources() {
+    auto rtSetup = TextureSetup::RenderTarget2D(this->offscreenWidth, this->offscreenHeight, PixelFormat::RGBA8, PixelFormat::None);
+    rtSetup.Sampler.WrapU = TextureWrapMode::ClampToEdge;
+    rtSetup.Sampler.WrapV = TextureWrapMode::ClampToEdge;
+    rtSetup.Sampler.MinFilter = TextureFilterMode::Linear;
+    rtSetup.Sampler.MagFilter = TextureFilterMode::Linear;
+    this->offscreenTexture = Gfx::CreateResource(rtSetup);
+    this->offscreenPass = Gfx::CreateResource(PassSetup::From(this->offscreenTexture));
+
+    // the render target has premultiplied alpha, and is drawn into the
+    // current pass as a triangle strip quad with the default UI shader
+    auto mshSetup = MeshSetup::Empty(4, Usage::Stream);
+    mshSetup.Layout = this->meshLayout;
+    this->compositeMesh = Gfx::CreateResource(mshSetup);
     Id shd = Gfx::CreateResource(NKUIShader::Setup());
-    auto ps = PipelineSetup::FromLayoutAndShader(mshSetup.Layout, shd);
+    auto ps = PipelineSetup::FromLayoutAndShader(this->meshLayout, shd);
+    ps.PrimType = PrimitiveType::TriangleStrip;
     ps.DepthStencilState.DepthWriteEnabled = false;
     ps.DepthStencilState.DepthCmpFunc = CompareFunc::Always;
     ps.BlendState.BlendEnabled = true;
-    ps.BlendState.SrcFactorRGB = BlendFactor::SrcAlpha;
+    ps.BlendState.SrcFactorRGB = BlendFactor::One;
     ps.BlendState.DstFactorRGB = BlendFactor::OneMinusSrcAlpha;
     ps.BlendState.ColorFormat = Gfx::DisplayAttrs().ColorPixelFormat;
     ps.BlendState.DepthFormat = Gfx::DisplayAttrs().DepthPixelFormat;
     ps.BlendState.ColorWriteMask = PixelChannel::RGB;
-    ps.RasterizerState.ScissorTestEnabled = true;
     ps.RasterizerState.CullFaceEnabled = false;
     ps.RasterizerState.SampleCount = Gfx::DisplayAttrs().SampleCount;
-    this->drawState.Pipeline = Gfx::CreateResource(ps);
+    this->compositePipeline = Gfx::CreateResource(ps);
+    this->compositeDrawState.Pipeline = this->compositePipeline;
+    this->compositeDrawState.Mesh[0] = this->compositeMesh;
+    this->compositeDrawState.FSTexture[NKUIShader::tex] = this->offscreenTexture;
+}
 
-    Gfx::PopResourceLabel();
+//------------------------------------------------------------------------------
+Id
+nkuiWrapper::createPipeline(const ShaderSetup& shdSetup, bool instanced) {
+    Id shd = Gfx::CreateResource(shdSetup);
+    auto ps = PipelineSetup::FromLayoutAndShader(this->compactVertices ? this->compactLayout : this->meshLayout, shd);
+    if (instanced) {
+        ps.Layouts[0] = this->quadLayout;
+        ps.Layouts[1] = this->instLayout;
+        ps.PrimType = PrimitiveType::TriangleStrip;
+    }
+    ps.DepthStencilState.DepthWriteEnabled = false;
+    ps.DepthStencilState.DepthCmpFunc = CompareFunc::Always;
+    ps.BlendState.BlendEnabled = true;
+    ps.BlendState.SrcFactorRGB = BlendFactor::SrcAlpha;
+    ps.BlendState.DstFactorRGB = BlendFactor::OneMinusSrcAlpha;
+    ps.RasterizerState.ScissorTestEnabled = true;
+    ps.RasterizerState.CullFaceEnabled = false;
+    if (this->offscreen) {
+        // the render target starts out transparent, and accumulates
+        // coverage in alpha, so that it can be composited premultiplied
+        ps.BlendState.SrcFactorAlpha = BlendFactor::One;
+        ps.BlendState.DstFactorAlpha = BlendFactor::OneMinusSrcAlpha;
+        ps.BlendState.ColorFormat = PixelFormat::RGBA8;
+        ps.BlendState.DepthFormat = PixelFormat::None;
+        ps.BlendState.ColorWriteMask = PixelChannel::RGBA;
+        ps.RasterizerState.SampleCount = 1;
+    }
+    else {
+        ps.BlendState.ColorFormat = Gfx::DisplayAttrs().ColorPixelFormat;
+        ps.BlendState.DepthFormat = Gfx::DisplayAttrs().DepthPixelFormat;
+        ps.BlendState.ColorWriteMask = PixelChannel::RGB;
+        ps.RasterizerState.SampleCount = Gfx::DisplayAttrs().SampleCount;
+    }
+    return Gfx::CreateResource(ps);
+}
+
+//------------------------------------------------------------------------------
+struct nk_image
+nkuiWrapper::createFontImage(const void* pixels, int width, int height, enum nk_font_atlas_format format) {
+    struct nk_image img = this->AllocImage();
+    if (!this->headless) {
+        const bool alpha = NK_FONT_ATLAS_ALPHA8 == format;
+        const PixelFormat::Code pixelFormat = alpha ? PixelFormat::L8 : PixelFormat::RGBA8;
+        auto texSetup = TextureSetup::FromPixelData2D(width, height, 1, pixelFormat);
+        texSetup.Sampler.WrapU = TextureWrapMode::ClampToEdge;
+        texSetup.Sampler.WrapV = TextureWrapMode::ClampToEdge;
+        texSetup.Sampler.MinFilter = TextureFilterMode::Nearest;
+        texSetup.Sampler.MagFilter = TextureFilterMode::Nearest;
+        const int imgSize = width * height * PixelFormat::ByteSize(pixelFormat);
+        texSetup.ImageData.Sizes[0][0] = imgSize;
+        Gfx::PushResourceLabel(this->gfxResLabel);
+        this->BindImage(img, Gfx::CreateResource(texSetup, pixels, imgSize));
+        Gfx::PopResourceLabel();
+        this->images[img.handle.id & ImageSlotMask].alpha = alpha;
+    }
+    return img;
+}
+
+//------------------------------------------------------------------------------
+Id
+nkuiWrapper::createChunkMesh() {
+    auto mshSetup = MeshSetup::Empty(this->chunkNumVertices, Usage::Stream, IndexType::Index16, this->chunkNumIndices, Usage::Stream);
+    mshSetup.Layout = this->compactVertices ? this->compactLayout : this->meshLayout;
+    return Gfx::CreateResource(mshSetup);
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiWrapper::packVertices(int chunkIndex) {
+    // nk_convert() can only cast to integer formats, so positions and UVs
+    // are quantized here: positions to quarter pixels (+/-8192 pixels range,
+    // nuklear's AA fringes are at half pixels), UVs to signed-normalized 16-bit
+    const geomChunk& chunk = this->chunks[chunkIndex];
+    const int numVertices = chunk.vtxByteSize / int(sizeof(struct nkui_draw_vertex));
+    o_assert_dbg(numVertices <= this->chunkNumVertices);
+    const nkui_draw_vertex* src = (const nkui_draw_vertex*) (((const uint8*)nk_buffer_memory_const(&this->buffers.vbuf)) + chunk.vtxByteOffset);
+    nkui_compact_vertex* dst = this->packedVertices;
+    for (int i = 0; i < numVertices; i++, src++, dst++) {
+        for (int j = 0; j < 2; j++) {
+            const float pos = src->position[j] * 4.0f;
+            dst->position[j] = short(std::min(std::max(pos + (pos < 0.0f ? -0.5f : 0.5f), -32768.0f), 32767.0f));
+            const float uv = src->uv[j] * 32767.0f;
+            dst->uv[j] = short(std::min(std::max(uv + (uv < 0.0f ? -0.5f : 0.5f), -32767.0f), 32767.0f));
+        }
+        dst->col[0] = src->col[0];
+        dst->col[1] = src->col[1];
+        dst->col[2] = src->col[2];
+        dst->col[3] = src->col[3];
+    }
+    return numVertices * int(sizeof(struct nkui_compact_vertex));
+}
+
+//------------------------------------------------------------------------------
+Id
+nkuiWrapper::chunkMesh(int chunkIndex) {
+    if (this->headless) {
+        return Id::InvalidId();
+    }
+    // meshes are created for all geometry buffers at once
+    const int index = this->meshIndex(chunkIndex);
+    if (index >= this->chunkMeshes.Size()) {
+        Gfx::PushResourceLabel(this->gfxResLabel);
+        while (index >= this->chunkMeshes.Size()) {
+            this->chunkMeshes.Add(this->createChunkMesh());
+        }
+        Gfx::PopResourceLabel();
+    }
+    return this->chunkMeshes[index];
+}
+
+//------------------------------------------------------------------------------
+Id
+nkuiWrapper::instChunkMesh(int instChunkIndex) {
+    if (this->headless) {
+        return Id::InvalidId();
+    }
+    const int index = this->meshIndex(instChunkIndex);
+    if (index >= this->instMeshes.Size()) {
+        Gfx::PushResourceLabel(this->gfxResLabel);
+        while (index >= this->instMeshes.Size()) {
+            auto mshSetup = MeshSetup::Empty(this->chunkNumInstances, Usage::Stream);
+            mshSetup.Layout = this->instLayout;
+            this->instMeshes.Add(Gfx::CreateResource(mshSetup));
+        }
+        Gfx::PopResourceLabel();
+    }
+    return this->instMeshes[index];
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::nextGeomBuffer() {
+    // the previous frame's geometry buffer may still be read by the GPU,
+    // when the ring wraps around, the oldest buffer is overwritten
+    const int next = (this->curGeomBuffer + 1) % this->numGeomBuffers;
+    if ((0 == next) && (InvalidIndex != this->curGeomBuffer)) {
+        this->stats.NumGeometryBufferWraps++;
+    }
+    this->curGeomBuffer = next;
 }
 
 //------------------------------------------------------------------------------
 struct nk_image
 nkuiWrapper::AllocImage() {
-    o_assert_dbg(!this->freeImageSlots.Empty());
-    return nk_image_id(this->freeImageSlots.PopBack());
+    int slot;
+    if (this->freeImageSlots.Empty()) {
+        o_assert(this->images.Size() < MaxImages);
+        slot = this->images.Size();
+        this->images.Add(imageEntry());
+    }
+    else {
+        slot = this->freeImageSlots.PopBack();
+    }
+    imageEntry& entry = this->images[slot];
+    o_assert_dbg(!entry.allocated);
+    entry.allocated = true;
+    this->stats.NumImages++;
+    return nk_image_id((entry.generation << ImageSlotBits) | slot);
 }
 
 //------------------------------------------------------------------------------
 void
 nkuiWrapper::FreeImage(const struct nk_image& image) {
-    int slot = image.handle.id;
-    o_assert_dbg(this->images[slot].IsValid());
-    this->images[slot].Invalidate();
+    const int slot = image.handle.id & ImageSlotMask;
+    o_assert_dbg(this->lookupImage(image.handle.id));
+    imageEntry& entry = this->images[slot];
+    const int atlasEntry = entry.atlasEntry;
+    if (entry.label.IsValid()) {
+        // texture was created by BindImagePixels()
+        Gfx::DestroyResources(entry.label);
+    }
+    entry.texture.Invalidate();
+    entry.label = ResourceLabel();
+    entry.atlasEntry = InvalidIndex;
+    entry.allocated = false;
+    entry.alpha = false;
+    entry.sdf = false;
+    // bump the generation so that stale handles are detected, skip 0
+    // so that a valid handle is never 0
+    entry.generation = (entry.generation < MaxImageGeneration) ? entry.generation + 1 : 1;
+    this->freeImageSlots.Add(slot);
+    this->stats.NumImages--;
+    if (InvalidIndex != atlasEntry) {
+        this->imageAtlas.Remove(atlasEntry);
+        this->updateAtlasPageImages();
+        this->geomValid = false;
+    }
 }
 
 //------------------------------------------------------------------------------
 void
 nkuiWrapper::BindImage(const struct nk_image& image, Id texId) {
-    int slot = image.handle.id;
-    o_assert_dbg(!this->images[slot].IsValid());
-    this->images[slot] = texId;
+    o_assert_dbg(this->lookupImage(image.handle.id));
+    imageEntry& entry = this->images[image.handle.id & ImageSlotMask];
+    o_assert_dbg(!entry.texture.IsValid());
+    entry.texture = texId;
+    // the placeholder texture may be baked into the offscreen render target
+    this->offscreenValid = false;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::BindImagePixels(const struct nk_image& image, int width, int height, const void* pixels) {
+    o_assert_dbg(this->lookupImage(image.handle.id));
+    o_assert_dbg((width > 0) && (height > 0) && pixels);
+    const int slot = image.handle.id & ImageSlotMask;
+    o_assert_dbg(!this->images[slot].texture.IsValid() && (InvalidIndex == this->images[slot].atlasEntry));
+
+    // small images go into a shared image atlas page if possible
+    if ((width <= this->imageAtlasMaxImageSize) && (height <= this->imageAtlasMaxImageSize)) {
+        const int atlasEntry = this->imageAtlas.Add(width, height, pixels);
+        if (InvalidIndex != atlasEntry) {
+            this->images[slot].atlasEntry = atlasEntry;
+            this->updateAtlasPageImages();
+            // the image may have moved pages around, force geometry update
+            this->geomValid = false;
+            this->updateMemoryStats();
+            return;
+        }
+    }
+
+    // otherwise create a texture owned by the image handle
+    if (!this->headless) {
+        auto texSetup = TextureSetup::FromPixelData2D(width, height, 1, PixelFormat::RGBA8);
+        texSetup.Sampler.WrapU = TextureWrapMode::ClampToEdge;
+        texSetup.Sampler.WrapV = TextureWrapMode::ClampToEdge;
+        texSetup.Sampler.MinFilter = TextureFilterMode::Linear;
+        texSetup.Sampler.MagFilter = TextureFilterMode::Linear;
+        const int imgSize = width * height * PixelFormat::ByteSize(PixelFormat::RGBA8);
+        texSetup.ImageData.Sizes[0][0] = imgSize;
+        imageEntry& entry = this->images[slot];
+        entry.label = Gfx::PushResourceLabel();
+        entry.texture = Gfx::CreateResource(texSetup, pixels, imgSize);
+        Gfx::PopResourceLabel();
+        // the placeholder texture may be baked into the offscreen render target
+        this->offscreenValid = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::updateAtlasPageImages() {
+    // allocate image handles for new atlas pages, and free handles
+    // (and textures) of evicted pages
+    while (this->atlasPageImages.Size() < this->imageAtlas.NumPages()) {
+        this->atlasPageImages.Add(0);
+    }
+    for (int i = 0; i < this->imageAtlas.NumPages(); i++) {
+        int& pageImage = this->atlasPageImages[i];
+        if (this->imageAtlas.PageValid(i) && (0 == pageImage)) {
+            pageImage = this->AllocImage().handle.id;
+        }
+        else if (!this->imageAtlas.PageValid(i) && (0 != pageImage)) {
+            this->FreeImage(nk_image_id(pageImage));
+            pageImage = 0;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::uploadAtlasPages() {
+    for (int i = 0; i < this->imageAtlas.NumPages(); i++) {
+        if (!this->imageAtlas.PageValid(i) || !this->imageAtlas.PageDirty(i)) {
+            continue;
+        }
+        this->imageAtlas.ClearDirty(i);
+        if (this->headless) {
+            continue;
+        }
+        // page textures are created on first upload
+        imageEntry& entry = this->images[this->atlasPageImages[i] & ImageSlotMask];
+        const int size = this->imageAtlas.PageSize();
+        if (!entry.texture.IsValid()) {
+            auto texSetup = TextureSetup::Empty2D(size, size, 1, PixelFormat::RGBA8, Usage::Dynamic);
+            texSetup.Sampler.WrapU = TextureWrapMode::ClampToEdge;
+            texSetup.Sampler.WrapV = TextureWrapMode::ClampToEdge;
+            texSetup.Sampler.MinFilter = TextureFilterMode::Linear;
+            texSetup.Sampler.MagFilter = TextureFilterMode::Linear;
+            entry.label = Gfx::PushResourceLabel();
+            entry.texture = Gfx::CreateResource(texSetup);
+            Gfx::PopResourceLabel();
+        }
+        ImageDataAttrs attrs;
+        attrs.NumFaces = 1;
+        attrs.NumMipMaps = 1;
+        attrs.Offsets[0][0] = 0;
+        attrs.Sizes[0][0] = this->imageAtlas.PageByteSize();
+        Gfx::UpdateTexture(entry.texture, this->imageAtlas.PagePixels(i), attrs);
+    }
 }
 
 //------------------------------------------------------------------------------
 void
 nkuiWrapper::BeginFontAtlas() {
+    o_assert_dbg(this->curFontAtlas < MaxNumFontAtlases);
     nk_font_atlas* atlas = &this->fontAtlases[this->curFontAtlas];
-    nk_font_atlas_init_default(atlas);
+    nk_font_atlas_init(atlas, &this->atlasAlloc);
     nk_font_atlas_begin(atlas);
 }
 
@@ -169,122 +821,2202 @@ nkuiWrapper::AddFont(const Buffer& ttfData, float fontHeight) {
     struct nk_font_config cfg = nk_font_config(0);
     cfg.oversample_h = 3; cfg.oversample_v = 2;
     nk_font* font = nk_font_atlas_add_from_memory(atlas, (void*)ttfData.Data(), ttfData.Size(), fontHeight, &cfg);
+    if (font) {
+        this->userFonts.Add(&font->handle);
+    }
     return font;
 }
 
+//------------------------------------------------------------------------------
+struct nkuiWrapper::dynamicFont {
+    struct nk_user_font handle;
+    nkuiWrapper* wrapper = nullptr;
+    int index = 0;
+    /// the TTF data must stay around for on-demand rasterization
+    Buffer ttfData;
+    struct nk_tt_fontinfo info;
+    float height = 0.0f;
+    float scale = 0.0f;
+    float ascent = 0.0f;
+    /// which glyph cache the font uses
+    glyphType type = CoverageGlyphs;
+};
+
+//------------------------------------------------------------------------------
+struct nk_user_font*
+nkuiWrapper::AddDynamicFont(const Buffer& ttfData, float fontHeight) {
+    return this->addDynamicFont(ttfData, fontHeight, CoverageGlyphs);
+}
+
+//------------------------------------------------------------------------------
+struct nk_user_font*
+nkuiWrapper::AddSDFFont(const Buffer& ttfData, float baseHeight) {
+    return this->addDynamicFont(ttfData, baseHeight, SDFGlyphs);
+}
+
+//------------------------------------------------------------------------------
+struct nk_user_font*
+nkuiWrapper::addDynamicFont(const Buffer& ttfData, float fontHeight, glyphType type) {
+    o_assert_dbg(this->dynamicFonts.Size() < MaxNumDynamicFonts);
+    o_assert_dbg(fontHeight > 0.0f);
+
+    // a glyph cache and its image handle are created with the first font using it
+    nkuiGlyphCache& cache = this->glyphCaches[type];
+    if (!cache.IsValid()) {
+        cache.Setup(this->glyphCacheSize);
+        this->glyphCacheImages[type] = this->AllocImage().handle.id;
+        imageEntry& entry = this->images[this->glyphCacheImages[type] & ImageSlotMask];
+        entry.alpha = CoverageGlyphs == type;
+        entry.sdf = SDFGlyphs == type;
+    }
+
+    dynamicFont* font = Memory::New<dynamicFont>();
+    font->ttfData.Add(ttfData.Data(), ttfData.Size());
+    const unsigned char* data = font->ttfData.Data();
+    if (!nk_tt_InitFont(&font->info, data, nk_tt_GetFontOffsetForIndex(data, 0))) {
+        Log::Warn("NKUI: failed to initialize dynamic font\n");
+        Memory::Delete(font);
+        return nullptr;
+    }
+    font->wrapper = this;
+    font->index = this->dynamicFonts.Size();
+    font->type = type;
+    font->height = fontHeight;
+    font->scale = nk_tt_ScaleForPixelHeight(&font->info, fontHeight);
+    int ascent, descent, lineGap;
+    nk_tt_GetFontVMetrics(&font->info, &ascent, &descent, &lineGap);
+    font->ascent = float(ascent) * font->scale;
+    font->handle.userdata = nk_handle_ptr(font);
+    font->handle.height = fontHeight;
+    font->handle.width = dynamicFontWidth;
+    font->handle.query = dynamicFontQuery;
+    font->handle.texture = nk_handle_id(this->glyphCacheImages[type]);
+    this->dynamicFonts.Add(font);
+    this->userFonts.Add(&font->handle);
+    if (this->textWidthCacheSize > 0) {
+        this->cacheTextWidths(&font->handle);
+    }
+    return &font->handle;
+}
+
+//------------------------------------------------------------------------------
+float
+nkuiWrapper::dynamicFontWidth(nk_handle handle, float height, const char* text, int len) {
+    // only needs the horizontal metrics, so this doesn't touch the glyph cache
+    const dynamicFont* font = (const dynamicFont*) handle.ptr;
+    const float scale = font->scale * (height / font->height);
+    float width = 0.0f;
+    int offset = 0;
+    nk_rune codepoint;
+    while (offset < len) {
+        const int glyphLen = nk_utf_decode(text + offset, &codepoint, len - offset);
+        if (0 == glyphLen) {
+            break;
+        }
+        offset += glyphLen;
+        int advance, lsb;
+        nk_tt_GetGlyphHMetrics(&font->info, nk_tt_FindGlyphIndex(&font->info, int(codepoint)), &advance, &lsb);
+        width += float(advance) * scale;
+    }
+    return width;
+}
+
+//------------------------------------------------------------------------------
+struct nkuiWrapper::cachedFont {
+    /// the wrapped font's userdata and callbacks
+    nk_handle userdata;
+    nk_text_width_f width = nullptr;
+    nk_query_font_glyph_f query = nullptr;
+    nkuiTextWidthCache cache;
+    ~cachedFont() {
+        if (this->cache.IsValid()) {
+            this->cache.Discard();
+        }
+    }
+};
+
 //------------------------------------------------------------------------------
 void
-nkuiWrapper::EndFontAtlas() {
-    nk_font_atlas* atlas = &this->fontAtlases[this->curFontAtlas++];
-    int imgWidth, imgHeight;
-    const void* imgData = nk_font_atlas_bake(atlas, &imgWidth, &imgHeight, NK_FONT_ATLAS_RGBA32);
-    auto texSetup = TextureSetup::FromPixelData2D(imgWidth, imgHeight, 1, PixelFormat::RGBA8);
-    texSetup.Sampler.WrapU = TextureWrapMode::ClampToEdge;
-    texSetup.Sampler.WrapV = TextureWrapMode::ClampToEdge;
-    texSetup.Sampler.MinFilter = TextureFilterMode::Nearest;
-    texSetup.Sampler.MagFilter = TextureFilterMode::Nearest;
-    const int imgSize = imgWidth*imgHeight * PixelFormat::ByteSize(PixelFormat::RGBA8);
-    texSetup.ImageData.Sizes[0][0] = imgSize;
-    struct nk_image img = this->AllocImage();
-    this->BindImage(img, Gfx::CreateResource(texSetup, imgData, imgSize));    
-    nk_font_atlas_end(atlas, img.handle, &this->config.null);
+nkuiWrapper::cacheTextWidths(struct nk_user_font* handle) {
+    o_assert_dbg(handle && handle->width && (handle->width != cachedFontWidth));
+    cachedFont* font = Memory::New<cachedFont>();
+    font->userdata = handle->userdata;
+    font->width = handle->width;
+    font->query = handle->query;
+    font->cache.Setup(this->textWidthCacheSize);
+    handle->userdata = nk_handle_ptr(font);
+    handle->width = cachedFontWidth;
+    handle->query = cachedFontQuery;
+    this->cachedFonts.Add(font);
+}
+
+//------------------------------------------------------------------------------
+float
+nkuiWrapper::cachedFontWidth(nk_handle handle, float height, const char* text, int len) {
+    cachedFont* font = (cachedFont*) handle.ptr;
+    const uint32 hash = nkuiTextWidthCache::Hash(height, text, len);
+    float width;
+    if (!font->cache.Lookup(hash, height, text, len, width)) {
+        width = font->width(font->userdata, height, text, len);
+        font->cache.Insert(hash, height, text, len, width);
+    }
+    return width;
 }
 
 //------------------------------------------------------------------------------
 void
-nkuiWrapper::NewFrame() {
-    nk_input_begin(&this->ctx);
-    if (Input::KeyboardAttached()) {
-        nk_input_key(&this->ctx, NK_KEY_DEL, Input::KeyDown(Key::Delete));
-        nk_input_key(&this->ctx, NK_KEY_ENTER, Input::KeyDown(Key::Enter));
-        nk_input_key(&this->ctx, NK_KEY_TAB, Input::KeyDown(Key::Tab));
-        nk_input_key(&this->ctx, NK_KEY_BACKSPACE, Input::KeyDown(Key::BackSpace));
-        nk_input_key(&this->ctx, NK_KEY_LEFT, Input::KeyDown(Key::Left));
-        nk_input_key(&this->ctx, NK_KEY_RIGHT, Input::KeyDown(Key::Right));
-        nk_input_key(&this->ctx, NK_KEY_UP, Input::KeyDown(Key::Up));
-        nk_input_key(&this->ctx, NK_KEY_DOWN, Input::KeyDown(Key::Down));
-        if (Input::KeyPressed(Key::LeftControl) || Input::KeyPressed(Key::RightControl)) {
-            nk_input_key(&this->ctx, NK_KEY_COPY, Input::KeyDown(Key::C));
-            nk_input_key(&this->ctx, NK_KEY_PASTE, Input::KeyDown(Key::V));
-            nk_input_key(&this->ctx, NK_KEY_CUT, Input::KeyDown(Key::X));
+nkuiWrapper::cachedFontQuery(nk_handle handle, float height, struct nk_user_font_glyph* glyph, nk_rune codepoint, nk_rune nextCodepoint) {
+    const cachedFont* font = (const cachedFont*) handle.ptr;
+    font->query(font->userdata, height, glyph, codepoint, nextCodepoint);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::dynamicFontQuery(nk_handle handle, float height, struct nk_user_font_glyph* glyph, nk_rune codepoint, nk_rune /*nextCodepoint*/) {
+    dynamicFont* font = (dynamicFont*) handle.ptr;
+    nkuiGlyphCache::glyph g;
+    font->wrapper->dynamicGlyph(font, codepoint, g);
+    const float scale = height / font->height;
+    glyph->width = (g.x1 - g.x0) * scale;
+    glyph->height = (g.y1 - g.y0) * scale;
+    glyph->offset = nk_vec2(g.x0 * scale, g.y0 * scale);
+    glyph->xadvance = g.xadvance * scale;
+    glyph->uv[0] = nk_vec2(g.u0, g.v0);
+    glyph->uv[1] = nk_vec2(g.u1, g.v1);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::dynamicGlyph(dynamicFont* font, nk_rune codepoint, nkuiGlyphCache::glyph& outGlyph) {
+    #if ORYOL_HAS_THREADS
+    std::lock_guard<std::mutex> lock(this->glyphCacheMutex);
+    #endif
+    nkuiGlyphCache& cache = this->glyphCaches[font->type];
+    const uint32 key = (uint32(font->index) << 21) | (uint32(codepoint) & 0x1FFFFF);
+    const nkuiGlyphCache::glyph* cached = cache.Lookup(key);
+    if (cached) {
+        outGlyph = *cached;
+        return;
+    }
+
+    // not cached, rasterize the glyph into a glyph cache cell, if the
+    // cache is full, the glyph is skipped but still advances the cursor,
+    // SDF glyphs are rasterized oversampled with a border for the distance
+    // field, and then downsampled
+    const int glyphIndex = nk_tt_FindGlyphIndex(&font->info, int(codepoint));
+    int advance, lsb;
+    nk_tt_GetGlyphHMetrics(&font->info, glyphIndex, &advance, &lsb);
+    const bool sdf = SDFGlyphs == font->type;
+    const int oversample = sdf ? SDFOversample : 1;
+    const float scale = font->scale * float(oversample);
+    int x0, y0, x1, y1;
+    nk_tt_GetGlyphBitmapBoxSubpixel(&font->info, glyphIndex, scale, scale, 0.0f, 0.0f, &x0, &y0, &x1, &y1);
+    int rasterWidth = x1 - x0;
+    int rasterHeight = y1 - y0;
+    int border = 0;
+    if (sdf && (rasterWidth > 0) && (rasterHeight > 0)) {
+        border = int(ceilf(this->sdfSpread)) * oversample;
+        rasterWidth = ((rasterWidth + 2 * border + oversample - 1) / oversample) * oversample;
+        rasterHeight = ((rasterHeight + 2 * border + oversample - 1) / oversample) * oversample;
+    }
+    const int w = rasterWidth / oversample;
+    const int h = rasterHeight / oversample;
+    int x, y;
+    nkuiGlyphCache::glyph* g = cache.Alloc(key, w, h, x, y);
+    if (g) {
+        if ((w > 0) && (h > 0)) {
+            const int pitch = cache.Size();
+            uint8* dst = cache.Pixels() + y * pitch + x;
+            if (sdf) {
+                uint8* raster = (uint8*) Memory::Alloc(rasterWidth * rasterHeight);
+                Memory::Clear(raster, rasterWidth * rasterHeight);
+                nk_tt_MakeGlyphBitmapSubpixel(&font->info, raster + border * rasterWidth + border,
+                    x1 - x0, y1 - y0, rasterWidth, scale, scale, 0.0f, 0.0f, glyphIndex, &this->atlasAlloc);
+                nkuiSDF::Generate(raster, rasterWidth, rasterHeight, oversample, this->sdfSpread, dst, pitch);
+                Memory::Free(raster);
+            }
+            else {
+                nk_tt_MakeGlyphBitmapSubpixel(&font->info, dst, w, h, pitch, scale, scale, 0.0f, 0.0f, glyphIndex, &this->atlasAlloc);
+            }
         }
-        else {
-            nk_input_key(&this->ctx, NK_KEY_COPY, 0);
-            nk_input_key(&this->ctx, NK_KEY_PASTE, 0);
-            nk_input_key(&this->ctx, NK_KEY_CUT, 0);
+        const float baseline = float(int(font->ascent + 0.5f));
+        g->x0 = float(x0 - border) / float(oversample);
+        g->y0 = float(y0 - border) / float(oversample) + baseline;
+        g->x1 = g->x0 + float(w);
+        g->y1 = g->y0 + float(h);
+        g->xadvance = float(advance) * font->scale;
+        outGlyph = *g;
+    }
+    else {
+        outGlyph = nkuiGlyphCache::glyph();
+        outGlyph.xadvance = float(advance) * font->scale;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::uploadGlyphCaches() {
+    for (int type = 0; type < NumGlyphTypes; type++) {
+        nkuiGlyphCache& cache = this->glyphCaches[type];
+        if (!cache.IsValid() || !cache.Dirty()) {
+            continue;
         }
-        const wchar_t* text = Input::Text();
-        while (wchar_t c = *text++) {
-            nk_input_unicode(&this->ctx, nk_rune(c));
+        cache.ClearDirty();
+        if (this->headless) {
+            continue;
+        }
+
+        // Oryol can only update whole textures, so the entire
+        // (single-channel) glyph cache is uploaded when it has changed
+        imageEntry& entry = this->images[this->glyphCacheImages[type] & ImageSlotMask];
+        const int size = cache.Size();
+        if (!entry.texture.IsValid()) {
+            // SDF glyphs are drawn scaled, so they need linear filtering
+            const TextureFilterMode::Code filter = (SDFGlyphs == type) ? TextureFilterMode::Linear : TextureFilterMode::Nearest;
+            auto texSetup = TextureSetup::Empty2D(size, size, 1, PixelFormat::L8, Usage::Dynamic);
+            texSetup.Sampler.WrapU = TextureWrapMode::ClampToEdge;
+            texSetup.Sampler.WrapV = TextureWrapMode::ClampToEdge;
+            texSetup.Sampler.MinFilter = filter;
+            texSetup.Sampler.MagFilter = filter;
+            Gfx::PushResourceLabel(this->gfxResLabel);
+            entry.texture = Gfx::CreateResource(texSetup);
+            Gfx::PopResourceLabel();
         }
+        ImageDataAttrs attrs;
+        attrs.NumFaces = 1;
+        attrs.NumMipMaps = 1;
+        attrs.Offsets[0][0] = 0;
+        attrs.Sizes[0][0] = size * size;
+        Gfx::UpdateTexture(entry.texture, cache.Pixels(), attrs);
     }
-    if (Input::MouseAttached()) {
-        const glm::vec2& mousePos = Input::MousePosition();
-        int x = int(mousePos.x);
-        int y = int(mousePos.y);
-        bool lmb = Input::MouseButtonPressed(MouseButton::Left)|Input::MouseButtonDown(MouseButton::Left);
-        bool mmb = Input::MouseButtonPressed(MouseButton::Middle)|Input::MouseButtonDown(MouseButton::Middle);
-        bool rmb = Input::MouseButtonPressed(MouseButton::Right)|Input::MouseButtonDown(MouseButton::Right);
-        nk_input_motion(&this->ctx, x, y);
-        glm::vec2 mouseScroll = Input::MouseScroll();
-        nk_input_scroll(&this->ctx, nk_vec2(mouseScroll.x, mouseScroll.y)  );
-        nk_input_button(&this->ctx, NK_BUTTON_LEFT, x, y, lmb);
-        nk_input_button(&this->ctx, NK_BUTTON_MIDDLE, x, y, mmb);
-        nk_input_button(&this->ctx, NK_BUTTON_RIGHT, x, y, rmb);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::EndFontAtlas() {
+    this->endFontAtlas(&this->fontAtlases[this->curFontAtlas++], nullptr);
+
+    // glyph uvs may have changed, force geometry update
+    this->geomValid = false;
+    this->updateMemoryStats();
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::EndFontAtlas(Buffer& cache) {
+    bool cacheUsed = this->endFontAtlas(&this->fontAtlases[this->curFontAtlas++], &cache);
+    this->geomValid = false;
+    this->updateMemoryStats();
+    return cacheUsed;
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::endFontAtlas(nk_font_atlas* atlas, Buffer* cache) {
+    const enum nk_font_atlas_format format = this->alphaFontAtlas ? NK_FONT_ATLAS_ALPHA8 : NK_FONT_ATLAS_RGBA32;
+    const uint64 key = cache ? this->fontAtlasKey(atlas, format) : 0;
+    const bool cacheUsed = cache && this->loadFontAtlas(atlas, key, format, *cache);
+    if (!cacheUsed) {
+        int imgWidth, imgHeight;
+        const void* imgData = nk_font_atlas_bake(atlas, &imgWidth, &imgHeight, format);
+        if (cache) {
+            this->saveFontAtlas(atlas, key, format, imgData, imgWidth, imgHeight, *cache);
+        }
+        struct nk_image img = this->createFontImage(imgData, imgWidth, imgHeight, format);
+        nk_font_atlas_end(atlas, img.handle, &this->config.null);
     }
-    nk_input_end(&this->ctx);
+    // baking (re-)initializes the font handles, so they can only be wrapped now
+    if (this->textWidthCacheSize > 0) {
+        for (nk_font* font = atlas->fonts; font; font = font->next) {
+            this->cacheTextWidths(&font->handle);
+        }
+    }
+    return cacheUsed;
+}
+
+//------------------------------------------------------------------------------
+uint64
+nkuiWrapper::fontAtlasKey(const nk_font_atlas* atlas, enum nk_font_atlas_format format) const {
+    uint64 key = 0xcbf29ce484222325ULL;
+    key = nkuiHashValue(key, nkuiFontCacheVersion);
+    key = nkuiHashValue(key, int(format));
+    key = nkuiHashValue(key, sizeof(struct nk_font_glyph));
+    key = nkuiHashValue(key, sizeof(struct nk_cursor));
+    for (const struct nk_font* font = atlas->fonts; font; font = font->next) {
+        const struct nk_font_config* cfg = font->config;
+        key = nkuiHash(key, cfg->ttf_blob, int(cfg->ttf_size));
+        key = nkuiHashValue(key, cfg->size);
+        key = nkuiHashValue(key, cfg->oversample_h);
+        key = nkuiHashValue(key, cfg->oversample_v);
+        key = nkuiHashValue(key, cfg->pixel_snap);
+        key = nkuiHashValue(key, cfg->coord_type);
+        key = nkuiHashValue(key, cfg->spacing);
+        key = nkuiHashValue(key, cfg->fallback_glyph);
+        for (const nk_rune* r = cfg->range; r && r[0]; r += 2) {
+            key = nkuiHashValue(key, r[0]);
+            key = nkuiHashValue(key, r[1]);
+        }
+    }
+    return key;
 }
 
 //------------------------------------------------------------------------------
 void
-nkuiWrapper::Draw() {
+nkuiWrapper::saveFontAtlas(const nk_font_atlas* atlas, uint64 key, enum nk_font_atlas_format format, const void* pixels, int width, int height, Buffer& cache) const {
+    nkuiFontCacheHeader hdr;
+    Memory::Clear(&hdr, sizeof(hdr));
+    hdr.magic = nkuiFontCacheMagic;
+    hdr.version = nkuiFontCacheVersion;
+    hdr.key = key;
+    hdr.format = int32(format);
+    hdr.texWidth = width;
+    hdr.texHeight = height;
+    hdr.numGlyphs = atlas->glyph_count;
+    hdr.custom = atlas->custom;
+    Memory::Copy(atlas->cursors, hdr.cursors, sizeof(hdr.cursors));
+    for (const struct nk_font* font = atlas->fonts; font; font = font->next) {
+        hdr.numFonts++;
+    }
+    const int pixelSize = width * height * nkuiFontAtlasBytesPerPixel(format);
+    cache.Clear();
+    cache.Reserve(int(sizeof(hdr) + hdr.numFonts * sizeof(nkuiFontCacheFont) + hdr.numGlyphs * sizeof(struct nk_font_glyph)) + pixelSize);
+    cache.Add((const uint8*)&hdr, sizeof(hdr));
+    for (const struct nk_font* font = atlas->fonts; font; font = font->next) {
+        nkuiFontCacheFont f;
+        f.height = font->info.height;
+        f.ascent = font->info.ascent;
+        f.descent = font->info.descent;
+        f.glyphOffset = font->info.glyph_offset;
+        f.glyphCount = font->info.glyph_count;
+        cache.Add((const uint8*)&f, sizeof(f));
+    }
+    cache.Add((const uint8*)atlas->glyphs, int(hdr.numGlyphs * sizeof(struct nk_font_glyph)));
+    cache.Add((const uint8*)pixels, pixelSize);
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::loadFontAtlas(nk_font_atlas* atlas, uint64 key, enum nk_font_atlas_format format, const Buffer& cache) {
 
-    // generate and upload vertex and index data
-    nk_buffer_clear(&this->vbuf);
-    nk_buffer_clear(&this->ibuf);
-    nk_convert(&this->ctx, &this->cmds, &this->vbuf, &this->ibuf, &this->config);
-    if (this->vbuf.needed > 0) {
-        Gfx::UpdateVertices(this->drawState.Mesh[0], this->vertexData, int(this->vbuf.needed));
+    // validate the cache blob, a stale or broken blob simply
+    // means that the atlas is baked as usual
+    nkuiFontCacheHeader hdr;
+    if (cache.Size() < int(sizeof(hdr))) {
+        return false;
+    }
+    Memory::Copy(cache.Data(), &hdr, sizeof(hdr));
+    if ((hdr.magic != nkuiFontCacheMagic) || (hdr.version != nkuiFontCacheVersion) ||
+        (hdr.key != key) || (hdr.format != int32(format)) ||
+        (hdr.texWidth <= 0) || (hdr.texHeight <= 0) || (hdr.numGlyphs <= 0)) {
+        return false;
+    }
+    int numFonts = 0;
+    for (const struct nk_font* font = atlas->fonts; font; font = font->next) {
+        numFonts++;
+    }
+    const int fontsOffset = int(sizeof(hdr));
+    const int glyphsOffset = fontsOffset + numFonts * int(sizeof(nkuiFontCacheFont));
+    const int pixelsOffset = glyphsOffset + hdr.numGlyphs * int(sizeof(struct nk_font_glyph));
+    const int pixelSize = hdr.texWidth * hdr.texHeight * nkuiFontAtlasBytesPerPixel(format);
+    if ((hdr.numFonts != numFonts) || (cache.Size() != (pixelsOffset + pixelSize))) {
+        return false;
     }
-    if (this->ibuf.needed > 0) {
-        Gfx::UpdateIndices(this->drawState.Mesh[0], this->indexData, int(this->ibuf.needed));
+    const nkuiFontCacheFont* fonts = (const nkuiFontCacheFont*) (cache.Data() + fontsOffset);
+    for (int i = 0; i < numFonts; i++) {
+        nkuiFontCacheFont f;
+        Memory::Copy(&fonts[i], &f, sizeof(f));
+        if ((f.glyphOffset + f.glyphCount) > nk_rune(hdr.numGlyphs)) {
+            return false;
+        }
     }
 
-    // compute projection matrix
-    const DisplayAttrs& attrs = Gfx::DisplayAttrs();
-    const float width = float(attrs.FramebufferWidth);
-    const float height = float(attrs.FramebufferHeight);
-    NKUIShader::vsParams vsParams;
-    vsParams.proj = glm::ortho(0.0f, width, height, 0.0f, -1.0f, 1.0f);
+    // rebuild the nuklear font atlas state without rasterizing, this
+    // does the same as nk_font_atlas_bake() and nk_font_atlas_end()
+    const int glyphsSize = hdr.numGlyphs * int(sizeof(struct nk_font_glyph));
+    atlas->glyphs = (struct nk_font_glyph*) atlas->permanent.alloc(atlas->permanent.userdata, 0, glyphsSize);
+    if (!atlas->glyphs) {
+        return false;
+    }
+    Memory::Copy(cache.Data() + glyphsOffset, atlas->glyphs, glyphsSize);
+    atlas->glyph_count = hdr.numGlyphs;
+    atlas->custom = hdr.custom;
+    Memory::Copy(hdr.cursors, atlas->cursors, sizeof(atlas->cursors));
+    int fontIndex = 0;
+    for (struct nk_font* font = atlas->fonts; font; font = font->next, fontIndex++) {
+        nkuiFontCacheFont f;
+        Memory::Copy(&fonts[fontIndex], &f, sizeof(f));
+        struct nk_font_config* cfg = font->config;
+        cfg->font->height = f.height;
+        cfg->font->ascent = f.ascent;
+        cfg->font->descent = f.descent;
+        cfg->font->glyph_offset = f.glyphOffset;
+        cfg->font->glyph_count = f.glyphCount;
+        cfg->font->ranges = cfg->range;
+        nk_font_init(font, cfg->size, cfg->fallback_glyph, atlas->glyphs, cfg->font, nk_handle_ptr(0));
+    }
 
-    // render draw commands
-    Id curTexture;
+    // the pixel data is uploaded straight from the cache blob
+    struct nk_image img = this->createFontImage(cache.Data() + pixelsOffset, hdr.texWidth, hdr.texHeight, format);
+    this->config.null.texture = img.handle;
+    this->config.null.uv = nk_vec2((atlas->custom.x + 0.5f) / float(hdr.texWidth), (atlas->custom.y + 0.5f) / float(hdr.texHeight));
+    for (struct nk_font* font = atlas->fonts; font; font = font->next) {
+        font->texture = img.handle;
+        font->handle.texture = img.handle;
+    }
+    for (int i = 0; i < NK_CURSOR_COUNT; i++) {
+        atlas->cursors[i].img.handle = img.handle;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::updateMemoryStats() {
+    if (this->ctxMemory) {
+        // the nuklear context allocates commands from the front and
+        // window state from the back of its fixed memory block, and
+        // silently drops commands (or asserts on new windows) once it's full
+        const nk_buffer& mem = this->ctx.memory;
+        NKUIStats::MemoryUsage& ctxUsage = this->stats.ContextMemory;
+        ctxUsage.CurrentBytes = int(mem.allocated + (mem.memory.size - mem.size));
+        ctxUsage.PeakBytes = std::max(ctxUsage.PeakBytes, std::max(ctxUsage.CurrentBytes, int(mem.needed)));
+        if (mem.needed > mem.memory.size) {
+            ctxUsage.NumBudgetOverruns++;
+            if (!this->ctxOverflowWarned) {
+                Log::Warn("NKUI: context memory full (%d bytes needed, NKUISetup::ContextMemorySize is %d bytes), UI commands are dropped\n",
+                    int(mem.needed), int(mem.memory.size));
+                this->ctxOverflowWarned = true;
+            }
+        }
+    }
+    else {
+        this->stats.ContextMemory = this->ctxPool.Usage();
+    }
+
+    this->stats.CommandMemory = this->cmdPool.Usage();
+    this->stats.GeometryMemory = this->geomPool.Usage();
+    this->stats.FontAtlasMemory = this->atlasPool.Usage();
+    this->stats.ImageAtlasMemory = this->imageAtlas.Usage();
+    this->stats.NumCachedGlyphs = 0;
+    this->stats.NumGlyphCacheEvictions = 0;
+    this->stats.NumGlyphCacheOverflows = 0;
+    for (const nkuiGlyphCache& cache : this->glyphCaches) {
+        this->stats.NumCachedGlyphs += cache.NumGlyphs();
+        this->stats.NumGlyphCacheEvictions += cache.NumEvictions();
+        this->stats.NumGlyphCacheOverflows += cache.NumOverflows();
+    }
+    this->stats.NumCachedTextWidths = 0;
+    this->stats.NumTextWidthCacheEvictions = 0;
+    for (const cachedFont* font : this->cachedFonts) {
+        this->stats.NumCachedTextWidths += font->cache.NumEntries();
+        this->stats.NumTextWidthCacheEvictions += font->cache.NumEvictions();
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::updateTextWidthStats() {
+    for (cachedFont* font : this->cachedFonts) {
+        this->curFrameStats.NumTextWidthHits += font->cache.NumHits();
+        this->curFrameStats.NumTextWidthMisses += font->cache.NumMisses();
+        font->cache.ResetCounters();
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::NewFrame() {
+    const TimePoint startTime = Clock::Now();
+    this->gatherInput(this->curInput, this->curRunes);
+    this->beginFrame(this->curInput, this->curRunes);
+    this->curFrameStats.NewFrameTime = Clock::Since(startTime);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::gatherInput(inputState& outInput, Array<nk_rune>& outRunes) const {
+    outInput = inputState();
+    outRunes.Clear();
+    if (this->headless) {
+        // no input in headless mode
+        return;
+    }
+    if (Input::KeyboardAttached()) {
+        static const struct {
+            enum nk_keys nkKey;
+            Key::Code key;
+        } keyMap[] = {
+            { NK_KEY_DEL, Key::Delete },
+            { NK_KEY_ENTER, Key::Enter },
+            { NK_KEY_TAB, Key::Tab },
+            { NK_KEY_BACKSPACE, Key::BackSpace },
+            { NK_KEY_LEFT, Key::Left },
+            { NK_KEY_RIGHT, Key::Right },
+            { NK_KEY_UP, Key::Up },
+            { NK_KEY_DOWN, Key::Down },
+        };
+        outInput.flags |= inputState::Keyboard;
+        for (const auto& k : keyMap) {
+            if (Input::KeyDown(k.key)) {
+                outInput.keys |= 1<<k.nkKey;
+            }
+        }
+        if (Input::KeyPressed(Key::LeftControl) || Input::KeyPressed(Key::RightControl)) {
+            outInput.keys |= Input::KeyDown(Key::C) ? (1<<NK_KEY_COPY) : 0;
+            outInput.keys |= Input::KeyDown(Key::V) ? (1<<NK_KEY_PASTE) : 0;
+            outInput.keys |= Input::KeyDown(Key::X) ? (1<<NK_KEY_CUT) : 0;
+        }
+        const wchar_t* text = Input::Text();
+        while (wchar_t c = *text++) {
+            outRunes.Add(nk_rune(c));
+        }
+    }
+    if (Input::MouseAttached()) {
+        glm::vec2 mousePos = Input::MousePosition();
+        if (this->offscreen) {
+            // map into the render target through the composite rect
+            mousePos.x = (mousePos.x - this->compositeRect[0]) * (float(this->offscreenWidth) / this->compositeRect[2]);
+            mousePos.y = (mousePos.y - this->compositeRect[1]) * (float(this->offscreenHeight) / this->compositeRect[3]);
+        }
+        outInput.flags |= inputState::Mouse;
+        outInput.mouseX = int(mousePos.x);
+        outInput.mouseY = int(mousePos.y);
+        if (Input::MouseButtonPressed(MouseButton::Left)|Input::MouseButtonDown(MouseButton::Left)) {
+            outInput.flags |= inputState::LeftButton;
+        }
+        if (Input::MouseButtonPressed(MouseButton::Middle)|Input::MouseButtonDown(MouseButton::Middle)) {
+            outInput.flags |= inputState::MiddleButton;
+        }
+        if (Input::MouseButtonPressed(MouseButton::Right)|Input::MouseButtonDown(MouseButton::Right)) {
+            outInput.flags |= inputState::RightButton;
+        }
+        const glm::vec2 mouseScroll = Input::MouseScroll();
+        outInput.scrollX = mouseScroll.x;
+        outInput.scrollY = mouseScroll.y;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::beginFrame(const inputState& input, const Array<nk_rune>& runes) {
+    // glyphs used from here on until Draw() are never evicted
+    for (nkuiGlyphCache& cache : this->glyphCaches) {
+        if (cache.IsValid()) {
+            cache.NewFrame();
+        }
+    }
+    for (cachedFont* font : this->cachedFonts) {
+        font->cache.NewFrame();
+    }
+    static_assert(NK_KEY_MAX <= 32, "inputState::keys needs one bit per nk_keys value");
+    nk_input_begin(&this->ctx);
+    if (input.flags & inputState::Keyboard) {
+        static const enum nk_keys keys[] = {
+            NK_KEY_DEL, NK_KEY_ENTER, NK_KEY_TAB, NK_KEY_BACKSPACE,
+            NK_KEY_LEFT, NK_KEY_RIGHT, NK_KEY_UP, NK_KEY_DOWN,
+            NK_KEY_COPY, NK_KEY_PASTE, NK_KEY_CUT
+        };
+        for (enum nk_keys key : keys) {
+            nk_input_key(&this->ctx, key, (input.keys & (1<<key)) ? 1 : 0);
+        }
+        for (nk_rune rune : runes) {
+            nk_input_unicode(&this->ctx, rune);
+        }
+    }
+    if (input.flags & inputState::Mouse) {
+        const int x = input.mouseX;
+        const int y = input.mouseY;
+        nk_input_motion(&this->ctx, x, y);
+        nk_input_scroll(&this->ctx, nk_vec2(input.scrollX, input.scrollY));
+        nk_input_button(&this->ctx, NK_BUTTON_LEFT, x, y, (input.flags & inputState::LeftButton) ? 1 : 0);
+        nk_input_button(&this->ctx, NK_BUTTON_MIDDLE, x, y, (input.flags & inputState::MiddleButton) ? 1 : 0);
+        nk_input_button(&this->ctx, NK_BUTTON_RIGHT, x, y, (input.flags & inputState::RightButton) ? 1 : 0);
+    }
+    nk_input_end(&this->ctx);
+
+    // idle-frame detection: nuklear resolves some state changes (hovering,
+    // window activation, popups) a frame late, so the UI keeps being
+    // updated for a few frames after anything happened
+    int fbWidth, fbHeight;
+    this->framebufferSize(fbWidth, fbHeight);
+    if (!this->geomValid || this->inputActive() || (fbWidth != this->prevFbWidth) || (fbHeight != this->prevFbHeight)) {
+        this->numUpdateFrames = this->idleSettleFrames;
+    }
+    if (this->updateRequested && (Clock::Since(this->updateRequestTime) >= this->updateDelay)) {
+        this->updateRequested = false;
+        this->numUpdateFrames = std::max(this->numUpdateFrames, 1);
+    }
+    this->needsUpdate = this->numUpdateFrames > 0;
+    if (this->needsUpdate) {
+        this->numUpdateFrames--;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::RequestUpdate(Duration delay) {
+    // only the earliest pending request is kept
+    if (this->updateRequested) {
+        const Duration remaining(this->updateDelay.AsTicks() - Clock::Since(this->updateRequestTime).AsTicks());
+        if (remaining <= delay) {
+            return;
+        }
+    }
+    this->updateRequested = true;
+    this->updateRequestTime = Clock::Now();
+    this->updateDelay = delay;
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::inputActive() const {
+    // held keys and mouse buttons count as active input, since nuklear
+    // repeats some actions while a button is held down
+    const struct nk_input& in = this->ctx.input;
+    if ((in.keyboard.text_len > 0) ||
+        (in.mouse.delta.x != 0.0f) || (in.mouse.delta.y != 0.0f) ||
+        (in.mouse.scroll_delta.x != 0.0f) || (in.mouse.scroll_delta.y != 0.0f)) {
+        return true;
+    }
+    for (int i = 0; i < NK_KEY_MAX; i++) {
+        if (in.keyboard.keys[i].down || in.keyboard.keys[i].clicked) {
+            return true;
+        }
+    }
+    for (int i = 0; i < NK_BUTTON_MAX; i++) {
+        if (in.mouse.buttons[i].down || in.mouse.buttons[i].clicked) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::windowsBegun() const {
+    for (const struct nk_window* win = this->ctx.begin; win; win = win->next) {
+        if (win->seq == this->ctx.seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::framebufferSize(int& outWidth, int& outHeight) const {
+    if (this->offscreen) {
+        outWidth = this->offscreenWidth;
+        outHeight = this->offscreenHeight;
+    }
+    else if (this->headless) {
+        outWidth = this->headlessWidth;
+        outHeight = this->headlessHeight;
+    }
+    else {
+        const DisplayAttrs& attrs = Gfx::DisplayAttrs();
+        outWidth = attrs.FramebufferWidth;
+        outHeight = attrs.FramebufferHeight;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::useCtxCmdStream() {
+    // NOTE: nk__begin() links the per-window command lists into a single
+    // stream, so after this the memory buffer content and the start
+    // offset completely define the UI geometry
+    const struct nk_command* first = nk__begin(&this->ctx);
+    this->cmds.base = (const uint8*) nk_buffer_memory_const(&this->ctx.memory);
+    this->cmds.size = int(this->ctx.memory.allocated);
+    this->cmds.begin = first ? int((const uint8*)first - this->cmds.base) : -1;
+
+    // collect the start offsets of all window-, popup- and overlay-command
+    // lists, segments are split at these offsets (if one is missed, two
+    // windows simply end up in the same segment)
+    this->segmentStarts.Clear();
+    for (const struct nk_window* win = this->ctx.begin; win; win = win->next) {
+        this->segmentStarts.Add(int(win->buffer.begin));
+        if (win->popup.buf.active) {
+            this->segmentStarts.Add(int(win->popup.buf.begin));
+        }
+    }
+    this->segmentStarts.Add(int(this->ctx.overlay.begin));
+    std::sort(this->segmentStarts.begin(), this->segmentStarts.end());
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::cmdStreamChanged() {
+    const uint8* ptr = this->cmds.base;
+    const int size = this->cmds.size;
+    const int begin = this->cmds.begin;
+    if (this->geomValid &&
+        (begin == this->prevCmdBegin) &&
+        (size == this->prevCmdStream.Size()) &&
+        ((0 == size) || (0 == memcmp(ptr, this->prevCmdStream.Data(), size)))) {
+        return false;
+    }
+    this->retainCmdStream();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::retainCmdStream() {
+    this->prevCmdBegin = this->cmds.begin;
+    this->prevCmdStream.Clear();
+    if (this->cmds.size > 0) {
+        this->prevCmdStream.Add(this->cmds.base, this->cmds.size);
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::useRetainedCmdStream() {
+    // NOTE: segmentStarts are still those of the retained stream, since
+    // they are only gathered in useCtxCmdStream()
+    const int size = this->prevCmdStream.Size();
+    this->cmds.base = (size > 0) ? this->prevCmdStream.Data() : nullptr;
+    this->cmds.size = size;
+    this->cmds.begin = (size > 0) ? this->prevCmdBegin : -1;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::BeginCapture(Buffer& capture_) {
+    o_assert_dbg(nullptr == this->capture);
+    nkuiCaptureHeader hdr;
+    Memory::Clear(&hdr, sizeof(hdr));
+    hdr.magic = nkuiCaptureMagic;
+    hdr.version = nkuiCaptureVersion;
+    hdr.pointerSize = int32(sizeof(void*));
+    hdr.commandSize = int32(sizeof(struct nk_command));
+    capture_.Clear();
+    capture_.Add((const uint8*)&hdr, sizeof(hdr));
+    this->capture = &capture_;
+    this->captureCmdsValid = false;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::EndCapture() {
+    this->capture = nullptr;
+    this->captureCmds.Clear();
+    this->captureScratch.Clear();
+    this->captureCmdsValid = false;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::patchCapturedCmds(uint8* base, int size, int begin, bool toIndices) const {
+    if (begin < 0) {
+        return;
+    }
+    struct nk_command* cmd = (struct nk_command*)(base + begin);
+    for (;;) {
+        if (NK_COMMAND_TEXT == cmd->type) {
+            struct nk_command_text* t = (struct nk_command_text*)cmd;
+            if (toIndices) {
+                // copies of a font (e.g. SDF fonts with a different height) share the userdata
+                int index = 0;
+                for (int i = 0; i < this->userFonts.Size(); i++) {
+                    const struct nk_user_font* font = this->userFonts[i];
+                    if ((font == t->font) || (font->userdata.ptr == t->font->userdata.ptr)) {
+                        index = i;
+                        break;
+                    }
+                }
+                t->font = (const struct nk_user_font*)(nk_size)index;
+            }
+            else {
+                const int index = int((nk_size)t->font);
+                t->font = this->userFonts[(index < this->userFonts.Size()) ? index : 0];
+            }
+        }
+        else if (toIndices && (NK_COMMAND_CUSTOM == cmd->type)) {
+            // custom callbacks can't be replayed
+            cmd->type = NK_COMMAND_NOP;
+        }
+        if (cmd->next >= nk_size(size)) {
+            break;
+        }
+        cmd = (struct nk_command*)(base + cmd->next);
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::captureFrame(bool idle) {
+    o_assert_dbg(this->capture);
+    nkuiCaptureFrame frame;
+    Memory::Clear(&frame, sizeof(frame));
+    frame.magic = nkuiCaptureFrameMagic;
+    int fbWidth, fbHeight;
+    this->framebufferSize(fbWidth, fbHeight);
+    frame.fbWidth = fbWidth;
+    frame.fbHeight = fbHeight;
+    frame.inputFlags = this->curInput.flags;
+    frame.keys = this->curInput.keys;
+    frame.mouseX = this->curInput.mouseX;
+    frame.mouseY = this->curInput.mouseY;
+    frame.scrollX = this->curInput.scrollX;
+    frame.scrollY = this->curInput.scrollY;
+    frame.numRunes = this->curRunes.Size();
+    frame.cmdBegin = -1;
+    if (idle) {
+        frame.flags |= nkuiCaptureIdle;
+    }
+    else {
+        // commands are patched in a copy, and only stored if they changed
+        frame.numSegmentStarts = this->segmentStarts.Size();
+        frame.cmdBegin = this->cmds.begin;
+        this->captureScratch.Clear();
+        if (this->cmds.size > 0) {
+            this->captureScratch.Add(this->cmds.base, this->cmds.size);
+            this->patchCapturedCmds(this->captureScratch.Data(), this->cmds.size, this->cmds.begin, true);
+        }
+        const int size = this->captureScratch.Size();
+        if (this->captureCmdsValid &&
+            (this->captureCmdsBegin == this->cmds.begin) &&
+            (this->captureCmds.Size() == size) &&
+            ((0 == size) || (0 == memcmp(this->captureCmds.Data(), this->captureScratch.Data(), size)))) {
+            frame.flags |= nkuiCaptureSameCmds;
+        }
+        else {
+            frame.cmdSize = size;
+            this->captureCmds.Clear();
+            if (size > 0) {
+                this->captureCmds.Add(this->captureScratch.Data(), size);
+            }
+            this->captureCmdsBegin = this->cmds.begin;
+            this->captureCmdsValid = true;
+        }
+    }
+    this->capture->Add((const uint8*)&frame, sizeof(frame));
+    if (frame.numRunes > 0) {
+        this->capture->Add((const uint8*)&this->curRunes[0], frame.numRunes * int(sizeof(nk_rune)));
+    }
+    for (int i = 0; i < frame.numSegmentStarts; i++) {
+        const int32 start = this->segmentStarts[i];
+        this->capture->Add((const uint8*)&start, sizeof(start));
+    }
+    if (frame.cmdSize > 0) {
+        this->capture->Add(this->captureCmds.Data(), frame.cmdSize);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::ReplayFrame(const Buffer& capture_, int& offset) {
+    o_assert_dbg(nullptr == this->capture);
+    const TimePoint startTime = Clock::Now();
+    if (0 == offset) {
+        nkuiCaptureHeader hdr;
+        if (capture_.Size() < int(sizeof(hdr))) {
+            return false;
+        }
+        Memory::Copy(capture_.Data(), &hdr, sizeof(hdr));
+        if ((hdr.magic != nkuiCaptureMagic) || (hdr.version != nkuiCaptureVersion) ||
+            (hdr.pointerSize != int32(sizeof(void*))) || (hdr.commandSize != int32(sizeof(struct nk_command)))) {
+            Log::Warn("NKUI: incompatible capture\n");
+            return false;
+        }
+        offset = int(sizeof(hdr));
+        this->replayCmds.Clear();
+    }
+    nkuiCaptureFrame frame;
+    if ((offset + int(sizeof(frame))) > capture_.Size()) {
+        return false;
+    }
+    Memory::Copy(capture_.Data() + offset, &frame, sizeof(frame));
+    const int runesOffset = offset + int(sizeof(frame));
+    const int startsOffset = runesOffset + frame.numRunes * int(sizeof(nk_rune));
+    const int cmdsOffset = startsOffset + frame.numSegmentStarts * int(sizeof(int32));
+    const int endOffset = cmdsOffset + frame.cmdSize;
+    if ((frame.magic != nkuiCaptureFrameMagic) || (frame.numRunes < 0) ||
+        (frame.numSegmentStarts < 0) || (frame.cmdSize < 0) || (endOffset > capture_.Size())) {
+        Log::Warn("NKUI: broken capture frame\n");
+        return false;
+    }
+    offset = endOffset;
+
+    inputState input;
+    input.flags = frame.inputFlags;
+    input.keys = frame.keys;
+    input.mouseX = frame.mouseX;
+    input.mouseY = frame.mouseY;
+    input.scrollX = frame.scrollX;
+    input.scrollY = frame.scrollY;
+    this->curInput = input;
+    this->curRunes.Clear();
+    for (int i = 0; i < frame.numRunes; i++) {
+        nk_rune rune;
+        Memory::Copy(capture_.Data() + runesOffset + i * int(sizeof(rune)), &rune, sizeof(rune));
+        this->curRunes.Add(rune);
+    }
+    if (0 == (frame.flags & nkuiCaptureIdle)) {
+        this->segmentStarts.Clear();
+        for (int i = 0; i < frame.numSegmentStarts; i++) {
+            int32 start;
+            Memory::Copy(capture_.Data() + startsOffset + i * int(sizeof(start)), &start, sizeof(start));
+            this->segmentStarts.Add(start);
+        }
+        if (0 == (frame.flags & nkuiCaptureSameCmds)) {
+            this->replayCmds.Clear();
+            if (frame.cmdSize > 0) {
+                this->replayCmds.Add(capture_.Data() + cmdsOffset, frame.cmdSize);
+                this->patchCapturedCmds(this->replayCmds.Data(), frame.cmdSize, frame.cmdBegin, false);
+            }
+        }
+        this->cmds.base = this->replayCmds.Data();
+        this->cmds.size = this->replayCmds.Size();
+        this->cmds.begin = (this->cmds.size > 0) ? frame.cmdBegin : -1;
+    }
+
+    // headless replays run at the captured framebuffer size
+    if (this->headless) {
+        this->headlessWidth = frame.fbWidth;
+        this->headlessHeight = frame.fbHeight;
+    }
+    this->beginFrame(input, this->curRunes);
+    this->curFrameStats.NewFrameTime = Clock::Since(startTime);
+    this->updateTextWidthStats();
+    this->drawFrame((0 != (frame.flags & nkuiCaptureIdle)) && this->geomValid);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::geomInsideRect(int chunkIndex, int elemOffset, int elemCount, int x0, int y0, int x1, int y1) const {
+    const geomChunk& chunk = this->chunks[chunkIndex];
+    const uint8* vtxBase = (const uint8*) nk_buffer_memory_const(&this->buffers.vbuf);
+    const uint8* idxBase = (const uint8*) nk_buffer_memory_const(&this->buffers.ibuf);
+    const nkui_draw_vertex* vertices = (const nkui_draw_vertex*) (vtxBase + chunk.vtxByteOffset);
+    const nk_draw_index* indices = ((const nk_draw_index*) (idxBase + chunk.idxByteOffset)) + elemOffset;
+    for (int i = 0; i < elemCount; i++) {
+        const float* pos = vertices[indices[i]].position;
+        if ((pos[0] < x0) || (pos[0] > x1) || (pos[1] < y0) || (pos[1] > y1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::clipDrawCmd(drawCmd& dc, const struct nk_rect& clipRect, int fbWidth, int fbHeight) {
+
+    // clip the scissor rect against the framebuffer, and drop
+    // the draw command if nothing would be visible
+    const int x0 = std::max(int(clipRect.x), 0);
+    const int y0 = std::max(int(clipRect.y), 0);
+    const int x1 = std::min(int(clipRect.x) + int(clipRect.w), fbWidth);
+    const int y1 = std::min(int(clipRect.y) + int(clipRect.h), fbHeight);
+    if ((x1 <= x0) || (y1 <= y0)) {
+        this->curFrameStats.NumCulledCommands++;
+        return false;
+    }
+    dc.clipX = x0;
+    dc.clipY = y0;
+    dc.clipW = x1 - x0;
+    dc.clipH = y1 - y0;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::mergeDrawCmd(drawCmd& prev, const drawCmd& dc) const {
+    // merging is only allowed if the resulting clip rect doesn't
+    // change what's visible of either part
+    const bool sameClip = (prev.clipX == dc.clipX) && (prev.clipY == dc.clipY) &&
+                          (prev.clipW == dc.clipW) && (prev.clipH == dc.clipH);
+    const bool prevContains = (prev.clipX <= dc.clipX) && (prev.clipY <= dc.clipY) &&
+                              ((prev.clipX + prev.clipW) >= (dc.clipX + dc.clipW)) &&
+                              ((prev.clipY + prev.clipH) >= (dc.clipY + dc.clipH));
+    const bool dcContains = (dc.clipX <= prev.clipX) && (dc.clipY <= prev.clipY) &&
+                            ((dc.clipX + dc.clipW) >= (prev.clipX + prev.clipW)) &&
+                            ((dc.clipY + dc.clipH) >= (prev.clipY + prev.clipH));
+    if (sameClip) {
+        prev.elemCount += dc.elemCount;
+        prev.insideClip &= dc.insideClip;
+        return true;
+    }
+    else if (prevContains && dc.insideClip) {
+        prev.elemCount += dc.elemCount;
+        return true;
+    }
+    else if (dcContains && prev.insideClip) {
+        prev.clipX = dc.clipX;
+        prev.clipY = dc.clipY;
+        prev.clipW = dc.clipW;
+        prev.clipH = dc.clipH;
+        prev.elemCount += dc.elemCount;
+        prev.insideClip = dc.insideClip;
+        return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::addDrawCmd(int chunkIndex, int imageId, const struct nk_rect& clipRect, int elemOffset, int elemCount, int fbWidth, int fbHeight) {
+    drawCmd dc;
+    if (!this->clipDrawCmd(dc, clipRect, fbWidth, fbHeight)) {
+        return;
+    }
+    dc.chunk = chunkIndex;
+    dc.imageId = imageId;
+    dc.elemOffset = elemOffset;
+    dc.elemCount = elemCount;
+    dc.insideClip = this->geomInsideRect(chunkIndex, elemOffset, elemCount, dc.clipX, dc.clipY, dc.clipX + dc.clipW, dc.clipY + dc.clipH);
+
+    // try to merge with the previous batch, this is only allowed if the
+    // geometry is contiguous and uses the same texture
+    if (!this->drawCmds.Empty()) {
+        drawCmd& prev = this->drawCmds.Back();
+        if ((InvalidIndex == prev.instChunk) && (prev.chunk == dc.chunk) && (prev.imageId == dc.imageId) &&
+            ((prev.elemOffset + prev.elemCount) == dc.elemOffset) && this->mergeDrawCmd(prev, dc)) {
+            return;
+        }
+    }
+    this->drawCmds.Add(dc);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::addInstDrawCmd(const segDrawCmd& sdc, const convertBuffers& bufs, int fbWidth, int fbHeight) {
+    drawCmd dc;
+    if (!this->clipDrawCmd(dc, sdc.clipRect, fbWidth, fbHeight)) {
+        return;
+    }
+    dc.imageId = sdc.imageId;
+    const int instSize = int(sizeof(struct nkui_instance));
+    const struct nkui_instance* src = (const struct nkui_instance*) (((const uint8*)nk_buffer_memory_const(&bufs.inst)) + sdc.instOffset);
+    int numInstances = sdc.elemCount;
+    while (numInstances > 0) {
+        // append to the previous instanced draw command if it has room
+        // left, and the clip rects allow merging, otherwise start a new
+        // instance chunk
+        const int x0 = dc.clipX * 4;
+        const int y0 = dc.clipY * 4;
+        const int x1 = (dc.clipX + dc.clipW) * 4;
+        const int y1 = (dc.clipY + dc.clipH) * 4;
+        int num = numInstances;
+        drawCmd* prev = this->drawCmds.Empty() ? nullptr : &this->drawCmds.Back();
+        if (prev && (InvalidIndex != prev->instChunk) && (prev->imageId == dc.imageId) && (prev->elemCount < this->chunkNumInstances)) {
+            num = std::min(num, this->chunkNumInstances - prev->elemCount);
+        }
+        else {
+            prev = nullptr;
+            num = std::min(num, this->chunkNumInstances);
+        }
+        dc.elemCount = num;
+        dc.insideClip = true;
+        for (int i = 0; i < num; i++) {
+            const short* r = src[i].rect;
+            if ((r[0] < x0) || (r[1] < y0) || (r[2] > x1) || (r[3] > y1)) {
+                dc.insideClip = false;
+                break;
+            }
+        }
+        // push the instances first, so that nothing is recorded if that fails
+        const nk_size instAllocated = this->instData.allocated;
+        nk_buffer_push(&this->instData, NK_BUFFER_FRONT, src, num * instSize, NK_ALIGNOF(struct nkui_instance));
+        if ((this->instData.allocated - instAllocated) < nk_size(num * instSize)) {
+            this->instData.allocated = instAllocated;
+            this->curFrameStats.NumDroppedCommands++;
+            return;
+        }
+        if (!(prev && this->mergeDrawCmd(*prev, dc))) {
+            if (this->instChunks.Size() >= this->maxNumInstChunks) {
+                this->instData.allocated = instAllocated;
+                this->curFrameStats.NumDroppedCommands++;
+                return;
+            }
+            instChunk chunk;
+            chunk.byteOffset = int(this->instData.allocated) - num * instSize;
+            dc.instChunk = this->instChunks.Size();
+            this->instChunks.Add(chunk);
+            this->drawCmds.Add(dc);
+        }
+        this->instChunks.Back().byteSize += num * instSize;
+        src += num;
+        numInstances -= num;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::estimateGeom(const struct nk_command* cmd, int& outNumVertices, int& outNumIndices) const {
+    // NOTE: all shapes are tessellated from a path, a path with N points
+    // generates at most 4*N vertices and 18*N indices (anti-aliased thick lines)
+    int numPoints = 0;
+    switch (cmd->type) {
+        case NK_COMMAND_LINE:
+        case NK_COMMAND_RECT_MULTI_COLOR:
+        case NK_COMMAND_IMAGE:
+            numPoints = 4;
+            break;
+        case NK_COMMAND_CURVE:
+            numPoints = this->curveSegments((const struct nk_command_curve*)cmd) + 1;
+            break;
+        case NK_COMMAND_RECT:
+        case NK_COMMAND_RECT_FILLED:
+            // 4 rounded corners with up to 4 points each
+            numPoints = 16;
+            break;
+        case NK_COMMAND_CIRCLE:
+            numPoints = this->circleSegments((float)((const struct nk_command_circle*)cmd)->w/2) + 1;
+            break;
+        case NK_COMMAND_CIRCLE_FILLED:
+            numPoints = this->circleSegments((float)((const struct nk_command_circle_filled*)cmd)->w/2) + 1;
+            break;
+        case NK_COMMAND_ARC:
+            if (this->adaptiveTessellation) {
+                const struct nk_command_arc* c = (const struct nk_command_arc*)cmd;
+                numPoints = this->tessellator.ArcSegments(this->circleSegments((float)c->r), c->a[0], c->a[1]) + 2;
+            }
+            else {
+                numPoints = this->config.arc_segment_count + 2;
+            }
+            break;
+        case NK_COMMAND_ARC_FILLED:
+            if (this->adaptiveTessellation) {
+                const struct nk_command_arc_filled* c = (const struct nk_command_arc_filled*)cmd;
+                numPoints = this->tessellator.ArcSegments(this->circleSegments((float)c->r), c->a[0], c->a[1]) + 2;
+            }
+            else {
+                numPoints = this->config.arc_segment_count + 2;
+            }
+            break;
+        case NK_COMMAND_TRIANGLE:
+        case NK_COMMAND_TRIANGLE_FILLED:
+            numPoints = 3;
+            break;
+        case NK_COMMAND_POLYGON:
+        case NK_COMMAND_POLYGON_FILLED:
+        case NK_COMMAND_POLYLINE:
+            numPoints = ((const struct nk_command_polygon*)cmd)->point_count;
+            break;
+        case NK_COMMAND_TEXT:
+            // one quad per glyph, and each glyph is at least one byte
+            outNumVertices = ((const struct nk_command_text*)cmd)->length * 4;
+            outNumIndices = ((const struct nk_command_text*)cmd)->length * 6;
+            return;
+        case NK_COMMAND_CUSTOM:
+            // can't know what the callback does, reserve a generous amount
+            numPoints = 1024;
+            break;
+        default:
+            break;
+    }
+    outNumVertices = numPoints * 4;
+    outNumIndices = numPoints * 18;
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiWrapper::circleSegments(float radius) const {
+    if (this->adaptiveTessellation) {
+        return this->tessellator.CircleSegments(radius);
+    }
+    else {
+        return this->config.circle_segment_count;
+    }
+}
+
+//------------------------------------------------------------------------------
+int
+nkuiWrapper::curveSegments(const struct nk_command_curve* q) const {
+    if (this->adaptiveTessellation) {
+        return this->tessellator.CurveSegments(q->begin.x, q->begin.y, q->ctrl[0].x, q->ctrl[0].y,
+            q->ctrl[1].x, q->ctrl[1].y, q->end.x, q->end.y);
+    }
+    else {
+        return this->config.curve_segment_count;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::pathCircle(struct nk_draw_list* list, struct nk_vec2 center, float radius, int numSegments) const {
+    // same points as nk_draw_list_path_arc_to(list, center, radius, 0, 2pi * (n-1)/n, n-1)
+    const int step = nkuiTessellator::TableSize / numSegments;
+    for (int i = 0; i < numSegments; i++) {
+        nk_draw_list_path_line_to(list, nk_vec2(center.x + radius * this->tessellator.Cos(i * step),
+            center.y + radius * this->tessellator.Sin(i * step)));
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::pathArc(struct nk_draw_list* list, struct nk_vec2 center, float radius, float a0, float a1, int circleSegs) const {
+    // rotate the table points to the start angle, the last segment is
+    // shortened to end exactly at a1, so only the end points need sinf/cosf
+    const int numSegments = this->tessellator.ArcSegments(circleSegs, a0, a1);
+    const int step = nkuiTessellator::TableSize / circleSegs;
+    const float dir = (a1 < a0) ? -1.0f : 1.0f;
+    const float c0 = cosf(a0);
+    const float s0 = sinf(a0);
+    for (int i = 0; i < numSegments; i++) {
+        const int index = (i * step) % nkuiTessellator::TableSize;
+        const float c = this->tessellator.Cos(index);
+        const float s = dir * this->tessellator.Sin(index);
+        nk_draw_list_path_line_to(list, nk_vec2(center.x + radius * (c0 * c - s0 * s),
+            center.y + radius * (s0 * c + c0 * s)));
+    }
+    nk_draw_list_path_line_to(list, nk_vec2(center.x + radius * cosf(a1), center.y + radius * sinf(a1)));
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::convertCommand(struct nk_draw_list* list, const struct nk_command* cmd) const {
+    // this is the command dispatcher from nk_convert()
+    switch (cmd->type) {
+        case NK_COMMAND_SCISSOR: {
+            const struct nk_command_scissor* s = (const struct nk_command_scissor*)cmd;
+            nk_draw_list_add_clip(list, nk_rect(s->x, s->y, s->w, s->h));
+        } break;
+        case NK_COMMAND_LINE: {
+            const struct nk_command_line* l = (const struct nk_command_line*)cmd;
+            nk_draw_list_stroke_line(list, nk_vec2(l->begin.x, l->begin.y),
+                nk_vec2(l->end.x, l->end.y), l->color, l->line_thickness);
+        } break;
+        case NK_COMMAND_CURVE: {
+            const struct nk_command_curve* q = (const struct nk_command_curve*)cmd;
+            nk_draw_list_stroke_curve(list, nk_vec2(q->begin.x, q->begin.y),
+                nk_vec2(q->ctrl[0].x, q->ctrl[0].y), nk_vec2(q->ctrl[1].x, q->ctrl[1].y),
+                nk_vec2(q->end.x, q->end.y), q->color,
+                this->curveSegments(q), q->line_thickness);
+        } break;
+        case NK_COMMAND_RECT: {
+            const struct nk_command_rect* r = (const struct nk_command_rect*)cmd;
+            nk_draw_list_stroke_rect(list, nk_rect(r->x, r->y, r->w, r->h),
+                r->color, (float)r->rounding, r->line_thickness);
+        } break;
+        case NK_COMMAND_RECT_FILLED: {
+            const struct nk_command_rect_filled* r = (const struct nk_command_rect_filled*)cmd;
+            nk_draw_list_fill_rect(list, nk_rect(r->x, r->y, r->w, r->h),
+                r->color, (float)r->rounding);
+        } break;
+        case NK_COMMAND_RECT_MULTI_COLOR: {
+            const struct nk_command_rect_multi_color* r = (const struct nk_command_rect_multi_color*)cmd;
+            nk_draw_list_fill_rect_multi_color(list, nk_rect(r->x, r->y, r->w, r->h),
+                r->left, r->top, r->right, r->bottom);
+        } break;
+        case NK_COMMAND_CIRCLE: {
+            const struct nk_command_circle* c = (const struct nk_command_circle*)cmd;
+            const struct nk_vec2 center = nk_vec2((float)c->x + (float)c->w/2, (float)c->y + (float)c->h/2);
+            if (!this->adaptiveTessellation) {
+                nk_draw_list_stroke_circle(list, center, (float)c->w/2, c->color,
+                    this->config.circle_segment_count, c->line_thickness);
+            }
+            else if (c->color.a) {
+                this->pathCircle(list, center, (float)c->w/2, this->circleSegments((float)c->w/2));
+                nk_draw_list_path_stroke(list, c->color, NK_STROKE_CLOSED, c->line_thickness);
+            }
+        } break;
+        case NK_COMMAND_CIRCLE_FILLED: {
+            const struct nk_command_circle_filled* c = (const struct nk_command_circle_filled*)cmd;
+            const struct nk_vec2 center = nk_vec2((float)c->x + (float)c->w/2, (float)c->y + (float)c->h/2);
+            if (!this->adaptiveTessellation) {
+                nk_draw_list_fill_circle(list, center, (float)c->w/2, c->color,
+                    this->config.circle_segment_count);
+            }
+            else if (c->color.a) {
+                this->pathCircle(list, center, (float)c->w/2, this->circleSegments((float)c->w/2));
+                nk_draw_list_path_fill(list, c->color);
+            }
+        } break;
+        case NK_COMMAND_ARC: {
+            const struct nk_command_arc* c = (const struct nk_command_arc*)cmd;
+            nk_draw_list_path_line_to(list, nk_vec2(c->cx, c->cy));
+            if (this->adaptiveTessellation) {
+                this->pathArc(list, nk_vec2(c->cx, c->cy), c->r, c->a[0], c->a[1], this->circleSegments((float)c->r));
+            }
+            else {
+                nk_draw_list_path_arc_to(list, nk_vec2(c->cx, c->cy), c->r,
+                    c->a[0], c->a[1], this->config.arc_segment_count);
+            }
+            nk_draw_list_path_stroke(list, c->color, NK_STROKE_CLOSED, c->line_thickness);
+        } break;
+        case NK_COMMAND_ARC_FILLED: {
+            const struct nk_command_arc_filled* c = (const struct nk_command_arc_filled*)cmd;
+            nk_draw_list_path_line_to(list, nk_vec2(c->cx, c->cy));
+            if (this->adaptiveTessellation) {
+                this->pathArc(list, nk_vec2(c->cx, c->cy), c->r, c->a[0], c->a[1], this->circleSegments((float)c->r));
+            }
+            else {
+                nk_draw_list_path_arc_to(list, nk_vec2(c->cx, c->cy), c->r,
+                    c->a[0], c->a[1], this->config.arc_segment_count);
+            }
+            nk_draw_list_path_fill(list, c->color);
+        } break;
+        case NK_COMMAND_TRIANGLE: {
+            const struct nk_command_triangle* t = (const struct nk_command_triangle*)cmd;
+            nk_draw_list_stroke_triangle(list, nk_vec2(t->a.x, t->a.y),
+                nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color,
+                t->line_thickness);
+        } break;
+        case NK_COMMAND_TRIANGLE_FILLED: {
+            const struct nk_command_triangle_filled* t = (const struct nk_command_triangle_filled*)cmd;
+            nk_draw_list_fill_triangle(list, nk_vec2(t->a.x, t->a.y),
+                nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color);
+        } break;
+        case NK_COMMAND_POLYGON: {
+            const struct nk_command_polygon* p = (const struct nk_command_polygon*)cmd;
+            for (int i = 0; i < p->point_count; i++) {
+                nk_draw_list_path_line_to(list, nk_vec2((float)p->points[i].x, (float)p->points[i].y));
+            }
+            nk_draw_list_path_stroke(list, p->color, NK_STROKE_CLOSED, p->line_thickness);
+        } break;
+        case NK_COMMAND_POLYGON_FILLED: {
+            const struct nk_command_polygon_filled* p = (const struct nk_command_polygon_filled*)cmd;
+            for (int i = 0; i < p->point_count; i++) {
+                nk_draw_list_path_line_to(list, nk_vec2((float)p->points[i].x, (float)p->points[i].y));
+            }
+            nk_draw_list_path_fill(list, p->color);
+        } break;
+        case NK_COMMAND_POLYLINE: {
+            const struct nk_command_polyline* p = (const struct nk_command_polyline*)cmd;
+            for (int i = 0; i < p->point_count; i++) {
+                nk_draw_list_path_line_to(list, nk_vec2((float)p->points[i].x, (float)p->points[i].y));
+            }
+            nk_draw_list_path_stroke(list, p->color, NK_STROKE_OPEN, p->line_thickness);
+        } break;
+        case NK_COMMAND_TEXT: {
+            const struct nk_command_text* t = (const struct nk_command_text*)cmd;
+            nk_draw_list_add_text(list, t->font, nk_rect(t->x, t->y, t->w, t->h),
+                t->string, t->length, t->height, t->foreground);
+        } break;
+        case NK_COMMAND_IMAGE: {
+            const struct nk_command_image* i = (const struct nk_command_image*)cmd;
+            nk_draw_list_add_image(list, i->img, nk_rect(i->x, i->y, i->w, i->h), i->col);
+        } break;
+        case NK_COMMAND_CUSTOM: {
+            const struct nk_command_custom* c = (const struct nk_command_custom*)cmd;
+            c->callback(list, c->x, c->y, c->w, c->h, c->callback_data);
+        } break;
+        default:
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::gatherSegments() {
+
+    // walk the command stream and split it into segments at the
+    // segment start offsets, also keep track of the scissor rect
+    // at the start of each segment
+    this->numSegments = 0;
+    struct nk_rect clipRect = nk_null_rect;
+    for (const struct nk_command* cmd = this->firstCmd(); cmd; cmd = this->nextCmd(cmd)) {
+        const int offset = int((const uint8*)cmd - this->cmds.base);
+        if ((0 == this->numSegments) ||
+            std::binary_search(this->segmentStarts.begin(), this->segmentStarts.end(), offset)) {
+            if (this->numSegments == this->segments.Size()) {
+                this->segments.Add(segment());
+            }
+            segment& seg = this->segments[this->numSegments++];
+            seg.first = cmd;
+            seg.numCmds = 0;
+            seg.clipRect = clipRect;
+        }
+        this->segments[this->numSegments - 1].numCmds++;
+        if (NK_COMMAND_SCISSOR == cmd->type) {
+            const struct nk_command_scissor* s = (const struct nk_command_scissor*)cmd;
+            clipRect = nk_rect(s->x, s->y, s->w, s->h);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::beginSegChunk(struct nk_draw_list* list, segment& seg, convertBuffers& bufs, const struct nk_rect& clipRect) {
+    segChunk chunk;
+    chunk.vtxByteOffset = int(bufs.vbuf.allocated);
+    chunk.idxByteOffset = int(bufs.ibuf.allocated);
+    chunk.firstDrawCmd = seg.drawCmds.Size();
+    seg.chunks.Add(chunk);
+    nk_draw_list_init(list);
+    nk_draw_list_setup(list, &this->config, &bufs.cmds, &bufs.vbuf, &bufs.ibuf,
+        this->config.line_AA, this->config.shape_AA);
+    nk_draw_list_add_clip(list, clipRect);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::endSegChunk(struct nk_draw_list* list, segment& seg, convertBuffers& bufs) {
+    segChunk& chunk = seg.chunks.Back();
+    chunk.vtxByteSize = int(bufs.vbuf.allocated) - chunk.vtxByteOffset;
+    chunk.idxByteSize = int(bufs.ibuf.allocated) - chunk.idxByteOffset;
+    int elemOffset = 0;
     const struct nk_draw_command* cmd = nullptr;
-    int elm_offset = 0;
-    nk_draw_foreach(cmd, &this->ctx, &this->cmds) {
-        int texSlot = int(cmd->texture.id);
-        const Id& newTexture = this->images[texSlot];
-        if (curTexture != newTexture) {
-            if (newTexture.IsValid()) {
+    nk_draw_list_foreach(cmd, list, &bufs.cmds) {
+        if (cmd->elem_count > 0) {
+            segDrawCmd dc;
+            dc.imageId = int(cmd->texture.id);
+            dc.clipRect = cmd->clip_rect;
+            dc.elemCount = int(cmd->elem_count);
+
+            // images which live in an image atlas page are drawn
+            // with the page texture and remapped UVs
+            const imageEntry* image = this->lookupImage(dc.imageId);
+            if (image && (InvalidIndex != image->atlasEntry)) {
+                dc.imageId = this->atlasPageImages[this->imageAtlas.Page(image->atlasEntry)];
+                this->remapAtlasUVs(bufs, chunk, elemOffset, dc.elemCount, this->imageAtlas.UVRect(image->atlasEntry));
+            }
+            seg.drawCmds.Add(dc);
+        }
+        elemOffset += int(cmd->elem_count);
+    }
+    chunk.numDrawCmds = seg.drawCmds.Size() - chunk.firstDrawCmd;
+    nk_buffer_clear(&bufs.cmds);
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::remapAtlasUVs(convertBuffers& bufs, const segChunk& chunk, int elemOffset, int elemCount, const float* uvRect) const {
+    // find the vertices referenced by the draw command, these are
+    // contiguous and not shared with other draw commands
+    const nk_draw_index* indices = (const nk_draw_index*) (((const uint8*)nk_buffer_memory_const(&bufs.ibuf)) + chunk.idxByteOffset) + elemOffset;
+    int minIndex = indices[0];
+    int maxIndex = indices[0];
+    for (int i = 1; i < elemCount; i++) {
+        minIndex = std::min(minIndex, int(indices[i]));
+        maxIndex = std::max(maxIndex, int(indices[i]));
+    }
+    struct nkui_draw_vertex* vertices = (struct nkui_draw_vertex*) (((uint8*)nk_buffer_memory(&bufs.vbuf)) + chunk.vtxByteOffset);
+    const float du = uvRect[2] - uvRect[0];
+    const float dv = uvRect[3] - uvRect[1];
+    for (int i = minIndex; i <= maxIndex; i++) {
+        vertices[i].uv[0] = uvRect[0] + vertices[i].uv[0] * du;
+        vertices[i].uv[1] = uvRect[1] + vertices[i].uv[1] * dv;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::convertSegment(segment& seg, convertBuffers& bufs) {
+    // NOTE: this may run on a worker thread, so it must only write
+    // to the segment and the conversion buffers
+    seg.chunks.Clear();
+    seg.drawCmds.Clear();
+    seg.numDroppedCmds = 0;
+
+    // with instanced quads, tessellated chunks are only started when
+    // needed and ended by instanced commands, to keep the draw order
+    struct nk_draw_list list;
+    struct nk_rect clipRect = seg.clipRect;
+    bool listOpen = false;
+    if (!this->instancedQuads) {
+        this->beginSegChunk(&list, seg, bufs, clipRect);
+        listOpen = true;
+    }
+    const struct nk_command* cmd = seg.first;
+    for (int i = 0; i < seg.numCmds; i++, cmd = this->nextCmd(cmd)) {
+        if (NK_COMMAND_SCISSOR == cmd->type) {
+            const struct nk_command_scissor* s = (const struct nk_command_scissor*)cmd;
+            clipRect = nk_rect(s->x, s->y, s->w, s->h);
+            if (!listOpen) {
+                continue;
+            }
+        }
+        else if (this->instancedQuads && this->instanceable(cmd)) {
+            if (listOpen) {
+                this->endSegChunk(&list, seg, bufs);
+                listOpen = false;
+            }
+            this->convertInstances(seg, bufs, cmd, clipRect);
+            continue;
+        }
+        if (!listOpen) {
+            this->beginSegChunk(&list, seg, bufs, clipRect);
+            listOpen = true;
+        }
+        int numVertices = 0, numIndices = 0;
+        this->estimateGeom(cmd, numVertices, numIndices);
+        if (((int(list.vertex_count) + numVertices) > this->chunkNumVertices) ||
+            ((int(list.element_count) + numIndices) > this->chunkNumIndices)) {
+            if (0 == list.vertex_count) {
+                // command doesn't even fit into an empty chunk
+                seg.numDroppedCmds++;
+                continue;
+            }
+            this->endSegChunk(&list, seg, bufs);
+            this->beginSegChunk(&list, seg, bufs, clipRect);
+        }
+        this->convertCommand(&list, cmd);
+        seg.chunks.Back().numCmds++;
+    }
+    if (listOpen) {
+        this->endSegChunk(&list, seg, bufs);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool
+nkuiWrapper::instanceable(const struct nk_command* cmd) const {
+    // only axis-aligned shapes which the instance shader can render
+    // exactly, everything else is tessellated
+    switch (cmd->type) {
+        case NK_COMMAND_RECT_FILLED:
+            return ((const struct nk_command_rect_filled*)cmd)->rounding <= 255;
+        case NK_COMMAND_RECT: {
+            const struct nk_command_rect* r = (const struct nk_command_rect*)cmd;
+            return (r->rounding <= 255) && (r->line_thickness <= 255);
+        }
+        case NK_COMMAND_CIRCLE_FILLED: {
+            const struct nk_command_circle_filled* c = (const struct nk_command_circle_filled*)cmd;
+            return (c->w == c->h) && (c->w <= 510);
+        }
+        case NK_COMMAND_CIRCLE: {
+            const struct nk_command_circle* c = (const struct nk_command_circle*)cmd;
+            return (c->w == c->h) && ((c->w + c->line_thickness) <= 510) && (c->line_thickness <= 255);
+        }
+        case NK_COMMAND_LINE: {
+            const struct nk_command_line* l = (const struct nk_command_line*)cmd;
+            return ((l->begin.x == l->end.x) || (l->begin.y == l->end.y)) && (l->line_thickness > 0);
+        }
+        case NK_COMMAND_TEXT:
+            return nullptr != ((const struct nk_command_text*)cmd)->font->query;
+        case NK_COMMAND_IMAGE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::pushInstance(segment& seg, convertBuffers& bufs, int imageId, const struct nk_rect& clipRect, float x0, float y0, float x1, float y1, struct nk_vec2 uv0, struct nk_vec2 uv1, struct nk_color col, int radius, int thickness) const {
+    if ((x1 <= clipRect.x) || (y1 <= clipRect.y) || (x0 >= (clipRect.x + clipRect.w)) || (y0 >= (clipRect.y + clipRect.h))) {
+        return;
+    }
+
+    // start a new draw command when the image or clip rect changes
+    segChunk& chunk = seg.chunks.Back();
+    segDrawCmd* dc = (chunk.numDrawCmds > 0) ? &seg.drawCmds.Back() : nullptr;
+    if (!dc || (dc->imageId != imageId) ||
+        (dc->clipRect.x != clipRect.x) || (dc->clipRect.y != clipRect.y) ||
+        (dc->clipRect.w != clipRect.w) || (dc->clipRect.h != clipRect.h)) {
+        segDrawCmd newDc;
+        newDc.imageId = imageId;
+        newDc.clipRect = clipRect;
+        newDc.instOffset = int(bufs.inst.allocated);
+        seg.drawCmds.Add(newDc);
+        chunk.numDrawCmds++;
+        dc = &seg.drawCmds.Back();
+    }
+    struct nkui_instance inst;
+    inst.rect[0] = short(std::min(std::max(floorf(x0 * 4.0f + 0.5f), -32767.0f), 32767.0f));
+    inst.rect[1] = short(std::min(std::max(floorf(y0 * 4.0f + 0.5f), -32767.0f), 32767.0f));
+    inst.rect[2] = short(std::min(std::max(floorf(x1 * 4.0f + 0.5f), -32767.0f), 32767.0f));
+    inst.rect[3] = short(std::min(std::max(floorf(y1 * 4.0f + 0.5f), -32767.0f), 32767.0f));
+    inst.uv[0] = short(uv0.x * 32767.0f + 0.5f);
+    inst.uv[1] = short(uv0.y * 32767.0f + 0.5f);
+    inst.uv[2] = short(uv1.x * 32767.0f + 0.5f);
+    inst.uv[3] = short(uv1.y * 32767.0f + 0.5f);
+    inst.col[0] = col.r;
+    inst.col[1] = col.g;
+    inst.col[2] = col.b;
+    inst.col[3] = col.a;
+    inst.shape[0] = nk_byte(radius);
+    inst.shape[1] = nk_byte(thickness);
+    inst.shape[2] = 0;
+    inst.shape[3] = 0;
+    const nk_size instAllocated = bufs.inst.allocated;
+    nk_buffer_push(&bufs.inst, NK_BUFFER_FRONT, &inst, sizeof(inst), NK_ALIGNOF(struct nkui_instance));
+    if ((bufs.inst.allocated - instAllocated) < sizeof(inst)) {
+        // out of memory, drop the instance
+        bufs.inst.allocated = instAllocated;
+        seg.numDroppedCmds++;
+        return;
+    }
+    dc->elemCount++;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::convertInstances(segment& seg, convertBuffers& bufs, const struct nk_command* cmd, const struct nk_rect& clipRect) const {
+    // NOTE: this may run on a worker thread, same as convertSegment()
+    if (seg.chunks.Empty() || !seg.chunks.Back().instanced) {
+        segChunk chunk;
+        chunk.instanced = true;
+        chunk.firstDrawCmd = seg.drawCmds.Size();
+        seg.chunks.Add(chunk);
+    }
+    seg.chunks.Back().numCmds++;
+
+    // solid shapes sample the white pixel of the font atlas, and
+    // get the global alpha applied like tessellated shapes
+    const int nullImage = int(this->config.null.texture.id);
+    const struct nk_vec2 nullUV = this->config.null.uv;
+    const float alpha = this->config.global_alpha;
+    switch (cmd->type) {
+        case NK_COMMAND_RECT_FILLED: {
+            const struct nk_command_rect_filled* r = (const struct nk_command_rect_filled*)cmd;
+            struct nk_color col = r->color;
+            col.a = nk_byte(float(col.a) * alpha);
+            const int radius = std::min(int(r->rounding), std::min(int(r->w), int(r->h)) / 2);
+            this->pushInstance(seg, bufs, nullImage, clipRect, float(r->x), float(r->y), float(r->x + r->w), float(r->y + r->h),
+                nullUV, nullUV, col, radius, 0);
+        } break;
+        case NK_COMMAND_RECT: {
+            // the stroke is centered on the rect outline
+            const struct nk_command_rect* r = (const struct nk_command_rect*)cmd;
+            struct nk_color col = r->color;
+            col.a = nk_byte(float(col.a) * alpha);
+            const float t = float(r->line_thickness) * 0.5f;
+            const int radius = std::min(int(r->rounding), std::min(int(r->w), int(r->h)) / 2);
+            this->pushInstance(seg, bufs, nullImage, clipRect, float(r->x) - t, float(r->y) - t, float(r->x + r->w) + t, float(r->y + r->h) + t,
+                nullUV, nullUV, col, (radius > 0) ? std::min(radius + int(t + 0.5f), 255) : 0, std::max(int(r->line_thickness), 1));
+        } break;
+        case NK_COMMAND_CIRCLE_FILLED: {
+            const struct nk_command_circle_filled* c = (const struct nk_command_circle_filled*)cmd;
+            struct nk_color col = c->color;
+            col.a = nk_byte(float(col.a) * alpha);
+            this->pushInstance(seg, bufs, nullImage, clipRect, float(c->x), float(c->y), float(c->x + c->w), float(c->y + c->h),
+                nullUV, nullUV, col, c->w / 2, 0);
+        } break;
+        case NK_COMMAND_CIRCLE: {
+            const struct nk_command_circle* c = (const struct nk_command_circle*)cmd;
+            struct nk_color col = c->color;
+            col.a = nk_byte(float(col.a) * alpha);
+            const float t = float(c->line_thickness) * 0.5f;
+            this->pushInstance(seg, bufs, nullImage, clipRect, float(c->x) - t, float(c->y) - t, float(c->x + c->w) + t, float(c->y + c->h) + t,
+                nullUV, nullUV, col, (c->w + c->line_thickness) / 2, std::max(int(c->line_thickness), 1));
+        } break;
+        case NK_COMMAND_LINE: {
+            // horizontal or vertical lines are a quad of line thickness
+            const struct nk_command_line* l = (const struct nk_command_line*)cmd;
+            struct nk_color col = l->color;
+            col.a = nk_byte(float(col.a) * alpha);
+            const float t = float(l->line_thickness) * 0.5f;
+            const float x0 = float(std::min(l->begin.x, l->end.x));
+            const float y0 = float(std::min(l->begin.y, l->end.y));
+            const float x1 = float(std::max(l->begin.x, l->end.x));
+            const float y1 = float(std::max(l->begin.y, l->end.y));
+            if (l->begin.y == l->end.y) {
+                this->pushInstance(seg, bufs, nullImage, clipRect, x0, y0 - t, x1, y1 + t, nullUV, nullUV, col, 0, 0);
+            }
+            else {
+                this->pushInstance(seg, bufs, nullImage, clipRect, x0 - t, y0, x1 + t, y1, nullUV, nullUV, col, 0, 0);
+            }
+        } break;
+        case NK_COMMAND_TEXT: {
+            // same glyph layout as nk_draw_list_add_text()
+            const struct nk_command_text* t = (const struct nk_command_text*)cmd;
+            const struct nk_user_font* font = t->font;
+            const int imageId = int(font->texture.id);
+            struct nk_color col = t->foreground;
+            col.a = nk_byte(float(col.a) * alpha);
+            float x = float(t->x);
+            const float y = float(t->y);
+            int textLen = 0;
+            nk_rune unicode = 0;
+            int glyphLen = nk_utf_decode(t->string, &unicode, t->length);
+            while ((textLen < t->length) && (glyphLen > 0) && (NK_UTF_INVALID != unicode)) {
+                nk_rune next = 0;
+                const int nextGlyphLen = nk_utf_decode(t->string + textLen + glyphLen, &next, t->length - textLen);
+                struct nk_user_font_glyph g;
+                font->query(font->userdata, t->height, &g, unicode, (NK_UTF_INVALID == next) ? '\0' : next);
+                if ((g.width > 0.0f) && (g.height > 0.0f)) {
+                    const float gx = x + g.offset.x;
+                    const float gy = y + g.offset.y;
+                    this->pushInstance(seg, bufs, imageId, clipRect, gx, gy, gx + g.width, gy + g.height, g.uv[0], g.uv[1], col, 0, 0);
+                }
+                textLen += glyphLen;
+                x += g.xadvance;
+                glyphLen = nextGlyphLen;
+                unicode = next;
+            }
+        } break;
+        case NK_COMMAND_IMAGE: {
+            const struct nk_command_image* i = (const struct nk_command_image*)cmd;
+            int imageId = int(i->img.handle.id);
+            struct nk_vec2 uv0 = nk_vec2(0.0f, 0.0f);
+            struct nk_vec2 uv1 = nk_vec2(1.0f, 1.0f);
+            if (nk_image_is_subimage(&i->img)) {
+                uv0 = nk_vec2(float(i->img.region[0]) / float(i->img.w), float(i->img.region[1]) / float(i->img.h));
+                uv1 = nk_vec2(float(i->img.region[0] + i->img.region[2]) / float(i->img.w), float(i->img.region[1] + i->img.region[3]) / float(i->img.h));
+            }
+            // images in an image atlas page are drawn with the page texture
+            const imageEntry* image = this->lookupImage(imageId);
+            if (image && (InvalidIndex != image->atlasEntry)) {
+                const float* uvRect = this->imageAtlas.UVRect(image->atlasEntry);
+                const float du = uvRect[2] - uvRect[0];
+                const float dv = uvRect[3] - uvRect[1];
+                uv0 = nk_vec2(uvRect[0] + uv0.x * du, uvRect[1] + uv0.y * dv);
+                uv1 = nk_vec2(uvRect[0] + uv1.x * du, uvRect[1] + uv1.y * dv);
+                imageId = this->atlasPageImages[this->imageAtlas.Page(image->atlasEntry)];
+            }
+            this->pushInstance(seg, bufs, imageId, clipRect, float(i->x), float(i->y), float(i->x + i->w), float(i->y + i->h),
+                uv0, uv1, i->col, 0, 0);
+        } break;
+        default:
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::joinSegment(const segment& seg, const convertBuffers& bufs, bool inPlace, int fbWidth, int fbHeight) {
+    const int vertexSize = int(sizeof(struct nkui_draw_vertex));
+    const int indexSize = int(sizeof(nk_draw_index));
+    this->curFrameStats.NumDroppedCommands += seg.numDroppedCmds;
+    for (const segChunk& segChunk : seg.chunks) {
+        if (segChunk.instanced) {
+            for (int i = 0; i < segChunk.numDrawCmds; i++) {
+                const segDrawCmd& dc = seg.drawCmds[segChunk.firstDrawCmd + i];
+                this->curFrameStats.NumNuklearCommands++;
+                this->curFrameStats.NumInstances += dc.elemCount;
+                this->addInstDrawCmd(dc, bufs, fbWidth, fbHeight);
+            }
+            continue;
+        }
+        const int numVertices = segChunk.vtxByteSize / vertexSize;
+        const int numIndices = segChunk.idxByteSize / indexSize;
+
+        // start a new geometry chunk if the segment chunk doesn't fit
+        if (!this->chunksExhausted && (this->chunks.Empty() ||
+            ((this->chunks.Back().vtxByteSize / vertexSize + numVertices) > this->chunkNumVertices) ||
+            ((this->chunks.Back().idxByteSize / indexSize + numIndices) > this->chunkNumIndices))) {
+            if (this->chunks.Size() < this->maxNumChunks) {
+                geomChunk chunk;
+                if (!this->chunks.Empty()) {
+                    const geomChunk& prev = this->chunks.Back();
+                    chunk.vtxByteOffset = prev.vtxByteOffset + prev.vtxByteSize;
+                    chunk.idxByteOffset = prev.idxByteOffset + prev.idxByteSize;
+                }
+                this->chunks.Add(chunk);
+            }
+            else {
+                this->chunksExhausted = true;
+            }
+        }
+        if (this->chunksExhausted) {
+            this->curFrameStats.NumDroppedCommands += segChunk.numCmds;
+            continue;
+        }
+
+        // move the geometry into the main buffers, rebasing the indices
+        // from segment-chunk-relative to geometry-chunk-relative
+        const int chunkIndex = this->chunks.Size() - 1;
+        geomChunk& chunk = this->chunks.Back();
+        const int baseVertex = chunk.vtxByteSize / vertexSize;
+        const int baseElement = chunk.idxByteSize / indexSize;
+        nk_draw_index* indices = nullptr;
+        if (inPlace) {
+            o_assert_dbg((chunk.vtxByteOffset + chunk.vtxByteSize) == segChunk.vtxByteOffset);
+            o_assert_dbg((chunk.idxByteOffset + chunk.idxByteSize) == segChunk.idxByteOffset);
+            indices = (nk_draw_index*) (((uint8*)nk_buffer_memory(&this->buffers.ibuf)) + segChunk.idxByteOffset);
+        }
+        else {
+            const uint8* srcVertices = ((const uint8*)nk_buffer_memory_const(&bufs.vbuf)) + segChunk.vtxByteOffset;
+            const uint8* srcIndices = ((const uint8*)nk_buffer_memory_const(&bufs.ibuf)) + segChunk.idxByteOffset;
+            const nk_size vtxAllocated = this->buffers.vbuf.allocated;
+            const nk_size idxAllocated = this->buffers.ibuf.allocated;
+            if (segChunk.vtxByteSize > 0) {
+                nk_buffer_push(&this->buffers.vbuf, NK_BUFFER_FRONT, srcVertices, segChunk.vtxByteSize, NK_ALIGNOF(struct nkui_draw_vertex));
+            }
+            if (segChunk.idxByteSize > 0) {
+                nk_buffer_push(&this->buffers.ibuf, NK_BUFFER_FRONT, srcIndices, segChunk.idxByteSize, NK_ALIGNOF(nk_draw_index));
+            }
+            if (((this->buffers.vbuf.allocated - vtxAllocated) < nk_size(segChunk.vtxByteSize)) ||
+                ((this->buffers.ibuf.allocated - idxAllocated) < nk_size(segChunk.idxByteSize))) {
+                // out of memory, drop the segment chunk, and a geometry chunk that stayed empty
+                this->buffers.vbuf.allocated = vtxAllocated;
+                this->buffers.ibuf.allocated = idxAllocated;
+                if ((0 == chunk.vtxByteSize) && (0 == chunk.idxByteSize)) {
+                    this->chunks.PopBack();
+                }
+                this->curFrameStats.NumDroppedCommands += segChunk.numCmds;
+                continue;
+            }
+            if (segChunk.idxByteSize > 0) {
+                indices = (nk_draw_index*) (((uint8*)nk_buffer_memory(&this->buffers.ibuf)) + this->buffers.ibuf.allocated - segChunk.idxByteSize);
+            }
+        }
+        if ((baseVertex > 0) && indices) {
+            for (int i = 0; i < numIndices; i++) {
+                indices[i] += nk_draw_index(baseVertex);
+            }
+        }
+        chunk.vtxByteSize += segChunk.vtxByteSize;
+        chunk.idxByteSize += segChunk.idxByteSize;
+
+        // record draw commands, element offsets are geometry-chunk-relative
+        int elmOffset = baseElement;
+        for (int i = 0; i < segChunk.numDrawCmds; i++) {
+            const segDrawCmd& dc = seg.drawCmds[segChunk.firstDrawCmd + i];
+            this->curFrameStats.NumNuklearCommands++;
+            this->addDrawCmd(chunkIndex, dc.imageId, dc.clipRect, elmOffset, dc.elemCount, fbWidth, fbHeight);
+            elmOffset += dc.elemCount;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::convert(int fbWidth, int fbHeight) {
+
+    // tessellate the nuklear command stream, this does the same as
+    // nk_convert(), but converts each window separately (optionally
+    // on worker threads), and splits the output into chunks which
+    // fit into 16-bit indexed meshes
+    nk_buffer_clear(&this->buffers.cmds);
+    nk_buffer_clear(&this->buffers.vbuf);
+    nk_buffer_clear(&this->buffers.ibuf);
+    nk_buffer_clear(&this->buffers.inst);
+    nk_buffer_clear(&this->instData);
+    this->drawCmds.Clear();
+    this->chunks.Clear();
+    this->instChunks.Clear();
+    this->chunksExhausted = false;
+    this->gatherSegments();
+    this->curFrameStats.NumSegments = this->numSegments;
+
+    if ((this->workerPool.NumThreads() > 0) && (this->numSegments > 1)) {
+        // convert segments in parallel into per-worker buffers...
+        for (convertBuffers& bufs : this->workerBuffers) {
+            nk_buffer_clear(&bufs.cmds);
+            nk_buffer_clear(&bufs.vbuf);
+            nk_buffer_clear(&bufs.ibuf);
+            nk_buffer_clear(&bufs.inst);
+        }
+        this->nextSegment = 0;
+        this->workerPool.Run([this](int workerIndex) {
+            convertBuffers& bufs = this->workerBuffers[workerIndex];
+            int segIndex;
+            while ((segIndex = this->nextSegment++) < this->numSegments) {
+                segment& seg = this->segments[segIndex];
+                seg.worker = workerIndex;
+                this->convertSegment(seg, bufs);
+            }
+        });
+        // ...and join them in draw order
+        for (int i = 0; i < this->numSegments; i++) {
+            const segment& seg = this->segments[i];
+            this->joinSegment(seg, this->workerBuffers[seg.worker], false, fbWidth, fbHeight);
+        }
+    }
+    else {
+        // convert segments directly into the main buffers
+        for (int i = 0; i < this->numSegments; i++) {
+            segment& seg = this->segments[i];
+            this->convertSegment(seg, this->buffers);
+            this->joinSegment(seg, this->buffers, true, fbWidth, fbHeight);
+        }
+    }
+    this->curFrameStats.NumChunks = this->chunks.Size();
+    this->geomValid = true;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::uploadGeometry() {
+
+    // upload each chunk into its own stream mesh of the next geometry buffer
+    this->nextGeomBuffer();
+    this->curFrameStats.GeometryBuffer = this->curGeomBuffer;
+    const uint8* vtxBase = (const uint8*) nk_buffer_memory_const(&this->buffers.vbuf);
+    const uint8* idxBase = (const uint8*) nk_buffer_memory_const(&this->buffers.ibuf);
+    for (int i = 0; i < this->chunks.Size(); i++) {
+        const geomChunk& chunk = this->chunks[i];
+        const Id mesh = this->chunkMesh(i);
+        const void* vtxData = vtxBase + chunk.vtxByteOffset;
+        int vtxByteSize = chunk.vtxByteSize;
+        if (this->compactVertices) {
+            vtxData = this->packedVertices;
+            vtxByteSize = this->packVertices(i);
+        }
+        if (mesh.IsValid() && (vtxByteSize > 0)) {
+            Gfx::UpdateVertices(mesh, vtxData, vtxByteSize);
+        }
+        if (mesh.IsValid() && (chunk.idxByteSize > 0)) {
+            Gfx::UpdateIndices(mesh, idxBase + chunk.idxByteOffset, chunk.idxByteSize);
+        }
+        this->curFrameStats.NumVertices += chunk.vtxByteSize / int(sizeof(struct nkui_draw_vertex));
+        this->curFrameStats.NumIndices += chunk.idxByteSize / int(sizeof(nk_draw_index));
+        this->curFrameStats.NumUploadedBytes += vtxByteSize + chunk.idxByteSize;
+    }
+    const uint8* instBase = (const uint8*) nk_buffer_memory_const(&this->instData);
+    for (int i = 0; i < this->instChunks.Size(); i++) {
+        const instChunk& chunk = this->instChunks[i];
+        const Id mesh = this->instChunkMesh(i);
+        if (mesh.IsValid()) {
+            Gfx::UpdateVertices(mesh, instBase + chunk.byteOffset, chunk.byteSize);
+        }
+        this->curFrameStats.NumUploadedBytes += chunk.byteSize;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::submit(int fbWidth, int fbHeight) {
+
+    // compute projection matrix
+    const float width = float(fbWidth);
+    const float height = float(fbHeight);
+    NKUIShader::vsParams vsParams;
+    vsParams.proj = glm::ortho(0.0f, width, height, 0.0f, -1.0f, 1.0f);
+
+    // render draw commands, skip redundant state changes, in
+    // headless mode only the state tracking happens
+    Id curTexture;
+    Id curPipeline;
+    int curChunk = -1;
+    int curClip[4] = { -1, -1, -1, -1 };
+    for (const drawCmd& cmd : this->drawCmds) {
+        // unbound or stale images are rendered with the white texture
+        const imageEntry* image = this->lookupImage(cmd.imageId);
+        const bool bound = image && image->texture.IsValid();
+        const Id& newTexture = bound ? image->texture : this->whiteTexture;
+        const bool instanced = InvalidIndex != cmd.instChunk;
+        Id newPipeline = instanced ? this->instRgbaPipeline : this->rgbaPipeline;
+        if (bound && image->alpha) {
+            newPipeline = instanced ? this->instAlphaPipeline : this->alphaPipeline;
+        }
+        else if (bound && image->sdf) {
+            newPipeline = instanced ? this->instSdfPipeline : this->sdfPipeline;
+        }
+        // instance chunks are tracked as negative chunk indices
+        const int newChunk = instanced ? -(cmd.instChunk + 2) : cmd.chunk;
+        if ((curChunk != newChunk) || (curTexture != newTexture) || (curPipeline != newPipeline)) {
+            if (curPipeline != newPipeline) {
+                this->drawState.Pipeline = newPipeline;
+                curPipeline = newPipeline;
+            }
+            if (curChunk != newChunk) {
+                if (this->headless) {
+                    // no meshes in headless mode
+                }
+                else if (instanced) {
+                    this->drawState.Mesh[0] = this->quadMesh;
+                    this->drawState.Mesh[1] = this->instMeshes[this->meshIndex(cmd.instChunk)];
+                }
+                else {
+                    this->drawState.Mesh[0] = this->chunkMeshes[this->meshIndex(cmd.chunk)];
+                    this->drawState.Mesh[1] = Id::InvalidId();
+                }
+                curChunk = newChunk;
+            }
+            if (curTexture != newTexture) {
                 this->drawState.FSTexture[NKUIShader::tex] = newTexture;
+                curTexture = newTexture;
+                this->curFrameStats.NumTextureSwitches++;
+            }
+            if (!this->headless) {
+                Gfx::ApplyDrawState(this->drawState);
+                Gfx::ApplyUniformBlock(vsParams);
+            }
+            this->curFrameStats.NumDrawStateChanges++;
+        }
+        if ((curClip[0] != cmd.clipX) || (curClip[1] != cmd.clipY) ||
+            (curClip[2] != cmd.clipW) || (curClip[3] != cmd.clipH)) {
+            if (!this->headless) {
+                Gfx::ApplyScissorRect(cmd.clipX, fbHeight - (cmd.clipY + cmd.clipH), cmd.clipW, cmd.clipH);
+            }
+            curClip[0] = cmd.clipX;
+            curClip[1] = cmd.clipY;
+            curClip[2] = cmd.clipW;
+            curClip[3] = cmd.clipH;
+            this->curFrameStats.NumScissorRects++;
+        }
+        if (!this->headless) {
+            if (instanced) {
+                Gfx::Draw(PrimitiveGroup(0, 4), cmd.elemCount);
             }
             else {
-                this->drawState.FSTexture[NKUIShader::tex] = this->whiteTexture;
+                Gfx::Draw(PrimitiveGroup(cmd.elemOffset, cmd.elemCount));
             }
-            curTexture = newTexture;
-            Gfx::ApplyDrawState(this->drawState);
-            Gfx::ApplyUniformBlock(vsParams);
         }
-        Gfx::ApplyScissorRect((int)cmd->clip_rect.x,
-                              (int)(height - (cmd->clip_rect.y + cmd->clip_rect.h)),
-                              (int)(cmd->clip_rect.w),
-                              (int)(cmd->clip_rect.h));
-        if (cmd->elem_count > 0) {
-            Gfx::Draw(PrimitiveGroup(elm_offset, cmd->elem_count));
-            elm_offset += cmd->elem_count;
+        this->curFrameStats.NumDrawCalls++;
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::submitFrame(int fbWidth, int fbHeight) {
+    if (this->offscreen && !this->headless) {
+        Gfx::BeginPass(this->offscreenPass, PassAction::Clear(glm::vec4(0.0f)));
+        this->submit(fbWidth, fbHeight);
+        Gfx::EndPass();
+    }
+    else {
+        this->submit(fbWidth, fbHeight);
+    }
+    this->offscreenValid = true;
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::Composite(float x, float y, float width, float height) {
+    o_assert_dbg(this->offscreen);
+    o_assert_dbg((width > 0.0f) && (height > 0.0f));
+    this->compositeRect[0] = x;
+    this->compositeRect[1] = y;
+    this->compositeRect[2] = width;
+    this->compositeRect[3] = height;
+    if (this->headless) {
+        return;
+    }
+
+    // GL render targets are bottom-up
+    #if ORYOL_OPENGL
+    const float v0 = 1.0f, v1 = 0.0f;
+    #else
+    const float v0 = 0.0f, v1 = 1.0f;
+    #endif
+    struct nkui_draw_vertex quad[4] = {
+        { { x, y }, { 0.0f, v0 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+        { { x + width, y }, { 1.0f, v0 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+        { { x, y + height }, { 0.0f, v1 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+        { { x + width, y + height }, { 1.0f, v1 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+    };
+    Gfx::UpdateVertices(this->compositeMesh, quad, sizeof(quad));
+    const DisplayAttrs& attrs = Gfx::DisplayAttrs();
+    NKUIShader::vsParams vsParams;
+    vsParams.proj = glm::ortho(0.0f, float(attrs.FramebufferWidth), float(attrs.FramebufferHeight), 0.0f, -1.0f, 1.0f);
+    Gfx::ApplyDrawState(this->compositeDrawState);
+    Gfx::ApplyUniformBlock(vsParams);
+    Gfx::Draw(PrimitiveGroup(0, 4));
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::Draw() {
+    // if the app skipped its UI code in an idle frame (NKUISetup::IdleFrames),
+    // the last frame is re-presented, nk_clear() must not be called in
+    // this case since it would free all windows which haven't been begun
+    // in this frame
+    const bool idle = this->idleFrames && !this->needsUpdate && !this->windowsBegun();
+    if (!idle) {
+        this->useCtxCmdStream();
+    }
+    if (this->capture) {
+        this->captureFrame(idle);
+    }
+    this->updateTextWidthStats();
+    this->drawFrame(idle);
+    if (!idle) {
+        nk_clear(&this->ctx);
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::drawFrame(bool idle) {
+    int fbWidth, fbHeight;
+    this->framebufferSize(fbWidth, fbHeight);
+    if (idle) {
+        this->curFrameStats.Idle = true;
+        this->stats.NumIdleFrames++;
+        if (this->geomValid) {
+            if (!this->offscreen || !this->offscreenValid) {
+                TimePoint time = Clock::Now();
+                this->submitFrame(fbWidth, fbHeight);
+                this->curFrameStats.SubmitTime = Clock::LapTime(time);
+            }
+            this->pushFrameStats();
+            return;
+        }
+    }
+    if ((fbWidth != this->prevFbWidth) || (fbHeight != this->prevFbHeight)) {
+        // batching depends on the framebuffer size
+        this->geomValid = false;
+        this->prevFbWidth = fbWidth;
+        this->prevFbHeight = fbHeight;
+    }
+    TimePoint time = Clock::Now();
+    // offscreen instances always skip unchanged frames, since their
+    // render target doesn't need to be re-rendered either
+    bool changed = true;
+    if (idle) {
+        // an image was bound or freed after NewFrame() in an idle frame,
+        // rebuild the geometry from the last frame's command stream
+        this->useRetainedCmdStream();
+        this->convert(fbWidth, fbHeight);
+    }
+    else if ((this->retainedMode || this->offscreen) && !this->cmdStreamChanged()) {
+        changed = false;
+        this->curFrameStats.Skipped = true;
+        this->stats.NumSkippedFrames++;
+    }
+    else {
+        // cmdStreamChanged() has already retained the stream in retained mode
+        if (this->idleFrames && !this->retainedMode && !this->offscreen) {
+            this->retainCmdStream();
+        }
+        this->convert(fbWidth, fbHeight);
+    }
+    this->curFrameStats.ConvertTime = Clock::LapTime(time);
+    if (changed) {
+        this->uploadGeometry();
+    }
+    this->uploadAtlasPages();
+    this->uploadGlyphCaches();
+    this->curFrameStats.UploadTime = Clock::LapTime(time);
+    if (changed || !this->offscreen || !this->offscreenValid) {
+        this->submitFrame(fbWidth, fbHeight);
+    }
+    this->curFrameStats.SubmitTime = Clock::LapTime(time);
+    this->updateMemoryStats();
+    this->pushFrameStats();
+}
+
+//------------------------------------------------------------------------------
+void
+nkuiWrapper::pushFrameStats() {
+    if (this->frameStatsHistory.Size() < this->frameStatsWindowSize) {
+        this->frameStatsHistory.Add(this->curFrameStats);
+    }
+    else {
+        this->frameStatsHistory[this->frameStatsHead] = this->curFrameStats;
+    }
+    this->frameStatsHead = (this->frameStatsHead + 1) % this->frameStatsWindowSize;
+    this->lastFrameStats = this->curFrameStats;
+    this->curFrameStats = NKUIFrameStats();
+}
+
+//------------------------------------------------------------------------------
+static void
+nkuiAccumTiming(NKUIFrameTimings::Timing& timing, Duration d, int index, int64& sum) {
+    if ((0 == index) || (d < timing.Min)) {
+        timing.Min = d;
+    }
+    if ((0 == index) || (d > timing.Max)) {
+        timing.Max = d;
+    }
+    sum += d.AsTicks();
+}
+
+//------------------------------------------------------------------------------
+NKUIFrameTimings
+nkuiWrapper::FrameTimings() const {
+    NKUIFrameTimings timings;
+    const int num = this->frameStatsHistory.Size();
+    timings.NumFrames = num;
+    if (num > 0) {
+        int64 newFrameSum = 0, convertSum = 0, uploadSum = 0, submitSum = 0, totalSum = 0;
+        for (int i = 0; i < num; i++) {
+            const NKUIFrameStats& fs = this->frameStatsHistory[i];
+            nkuiAccumTiming(timings.NewFrame, fs.NewFrameTime, i, newFrameSum);
+            nkuiAccumTiming(timings.Convert, fs.ConvertTime, i, convertSum);
+            nkuiAccumTiming(timings.Upload, fs.UploadTime, i, uploadSum);
+            nkuiAccumTiming(timings.Submit, fs.SubmitTime, i, submitSum);
+            nkuiAccumTiming(timings.Total, fs.NewFrameTime + fs.ConvertTime + fs.UploadTime + fs.SubmitTime, i, totalSum);
         }
+        timings.NewFrame.Avg = Duration(newFrameSum / num);
+        timings.Convert.Avg = Duration(convertSum / num);
+        timings.Upload.Avg = Duration(uploadSum / num);
+        timings.Submit.Avg = Duration(submitSum / num);
+        timings.Total.Avg = Duration(totalSum / num);
     }
-    nk_clear(&this->ctx);
+    return timings;
 }
 
 } // namespace _priv
@@ -7,9 +7,24 @@
 #include "Core/Types.h"
 #include "Core/Assertion.h"
 #include "Core/Containers/StaticArray.h"
+#include "Core/Containers/Array.h"
 #include "Core/Containers/Buffer.h"
+#include "Core/Time/TimePoint.h"
+#include "Core/Time/Duration.h"
 #include "NKUI/NKUISetup.h"
+#include "NKUI/NKUIStats.h"
+#include "NKUI/NKUIFrameStats.h"
+#include "NKUI/nkuiMemPool.h"
+#include "NKUI/nkuiWorkerPool.h"
+#include "NKUI/nkuiImageAtlas.h"
+#include "NKUI/nkuiGlyphCache.h"
+#include "NKUI/nkuiTessellator.h"
+#include "NKUI/nkuiTextWidthCache.h"
 #include "Gfx/Gfx.h"
+#include <atomic>
+#if ORYOL_HAS_THREADS
+#include <mutex>
+#endif
 
 #if __GNUC__
 #pragma GCC diagnostic push
@@ -31,6 +46,26 @@ struct nkui_draw_vertex {
     nk_byte col[4];
 };
 
+/// packed vertex for NKUISetup::CompactVertices, quantized from nkui_draw_vertex before upload
+struct nkui_compact_vertex {
+    /// x, y in quarter pixels
+    short position[2];
+    /// u, v normalized
+    short uv[2];
+    nk_byte col[4];
+};
+
+/// per-instance record of the instanced quad renderer
+struct nkui_instance {
+    /// x0, y0, x1, y1 in quarter pixels
+    short rect[4];
+    /// u0, v0, u1, v1 normalized
+    short uv[4];
+    nk_byte col[4];
+    /// corner radius, stroke thickness (0: filled), unused, unused
+    nk_byte shape[4];
+};
+
 class nkuiWrapper {
 public:
     /// setup the wrapper
@@ -41,49 +76,523 @@ public:
     void NewFrame();
     /// draw current frame
     void Draw();
+    /// test if the UI needs to be evaluated in the current frame
+    bool NeedsUpdate() const;
+    /// request a UI update after a delay
+    void RequestUpdate(Duration delay);
+    /// draw the offscreen render target as a quad into the current pass
+    void Composite(float x, float y, float width, float height);
+    /// get the offscreen render target texture
+    Id OffscreenTexture() const;
     /// grab a new image handle
     struct nk_image AllocImage();
     /// free an image handle
     void FreeImage(const struct nk_image& image);
     /// bind an Oryol texture to an image handle
     void BindImage(const struct nk_image& image, Id texId);
+    /// bind RGBA8 pixel data to an image handle (small images go into an image atlas)
+    void BindImagePixels(const struct nk_image& image, int width, int height, const void* pixels);
     /// begin a font atlas
     void BeginFontAtlas();
     /// add a font to current font atlas
     nk_font* AddFont(const Buffer& ttfData, float fontHeight);
+    /// add a font which rasterizes glyphs on demand into the glyph cache
+    struct nk_user_font* AddDynamicFont(const Buffer& ttfData, float fontHeight);
+    /// add a dynamic font with signed-distance-field glyphs which can be drawn at any height
+    struct nk_user_font* AddSDFFont(const Buffer& ttfData, float baseHeight);
     /// end defining font atlas
     void EndFontAtlas();
+    /// end defining font atlas, load from or write to a baked font atlas cache
+    bool EndFontAtlas(Buffer& cache);
+    /// start appending each frame's input and nuklear commands to a capture blob
+    void BeginCapture(Buffer& capture);
+    /// stop capturing
+    void EndCapture();
+    /// replay the next frame of a capture blob instead of NewFrame() and Draw()
+    bool ReplayFrame(const Buffer& capture, int& offset);
+    /// get stats of the last completed frame
+    const NKUIFrameStats& FrameStats() const;
+    /// compute timings over the rolling frame stats window
+    NKUIFrameTimings FrameTimings() const;
 
     nk_context ctx;
+    NKUIStats stats;
 
 private:
+    struct convertBuffers;
+    struct segChunk;
+    struct segDrawCmd;
+    struct segment;
+    struct drawCmd;
+    struct dynamicFont;
+    struct cachedFont;
+
     /// create Oryol render resources
     void createResources(const NKUISetup& setup);
+    /// initialize a set of conversion buffers
+    void initConvertBuffers(convertBuffers& bufs, int numVertices, int numIndices);
+    /// free a set of conversion buffers
+    void freeConvertBuffers(convertBuffers& bufs);
+    /// update the memory usage statistics
+    void updateMemoryStats();
+    /// push the current frame stats into the rolling window
+    void pushFrameStats();
+    /// the input of a frame, gathered from Oryol Input or read from a capture
+    struct inputState {
+        enum {
+            Keyboard = 1<<0,
+            Mouse = 1<<1,
+            LeftButton = 1<<2,
+            MiddleButton = 1<<3,
+            RightButton = 1<<4,
+        };
+        uint32 flags = 0;
+        /// down state of nuklear keys, one bit per nk_keys value
+        uint32 keys = 0;
+        int32 mouseX = 0;
+        int32 mouseY = 0;
+        float scrollX = 0.0f;
+        float scrollY = 0.0f;
+    };
+    /// gather the input of the current frame from Oryol Input
+    void gatherInput(inputState& outInput, Array<nk_rune>& outRunes) const;
+    /// feed input into nuklear, and update the idle-frame detection
+    void beginFrame(const inputState& input, const Array<nk_rune>& runes);
+    /// convert and submit a frame, or re-present the last geometry in an idle frame
+    void drawFrame(bool idle);
+    /// use the nuklear context's command stream for the current frame
+    void useCtxCmdStream();
+    /// first command of the current command stream, nullptr if empty
+    const struct nk_command* firstCmd() const;
+    /// next command in the current command stream, nullptr at the end (same as nk__next())
+    const struct nk_command* nextCmd(const struct nk_command* cmd) const;
+    /// append the current frame to the capture blob
+    void captureFrame(bool idle);
+    /// replace font pointers in text commands with font indices and vice versa, and custom commands with nops
+    void patchCapturedCmds(uint8* base, int size, int begin, bool toIndices) const;
+    /// check if nuklear command stream has changed since last frame, and remember it
+    bool cmdStreamChanged();
+    /// keep a copy of the current command stream for retained mode and idle frames
+    void retainCmdStream();
+    /// use the command stream retained from the last converted frame
+    void useRetainedCmdStream();
+    /// get the current framebuffer size (or the headless size)
+    void framebufferSize(int& outWidth, int& outHeight) const;
+    /// test if the input of the current frame can change the UI
+    bool inputActive() const;
+    /// test if any nuklear window was begun in the current frame
+    bool windowsBegun() const;
+    /// generate vertices and indices, and record draw commands
+    void convert(int fbWidth, int fbHeight);
+    /// upload the generated geometry to the meshes of the next geometry buffer
+    void uploadGeometry();
+    /// split the nuklear command stream into per-window segments
+    void gatherSegments();
+    /// conservative estimate of vertices and indices generated by a nuklear command
+    void estimateGeom(const struct nk_command* cmd, int& outNumVertices, int& outNumIndices) const;
+    /// tessellate a single nuklear command into a draw list
+    void convertCommand(struct nk_draw_list* list, const struct nk_command* cmd) const;
+    /// number of segments of a full circle (adaptive or fixed)
+    int circleSegments(float radius) const;
+    /// number of segments of a bezier curve command (adaptive or fixed)
+    int curveSegments(const struct nk_command_curve* q) const;
+    /// add the points of a full circle from the sin/cos table to the draw list path
+    void pathCircle(struct nk_draw_list* list, struct nk_vec2 center, float radius, int numSegments) const;
+    /// add the points of an arc from the sin/cos table to the draw list path
+    void pathArc(struct nk_draw_list* list, struct nk_vec2 center, float radius, float a0, float a1, int circleSegs) const;
+    /// tessellate a segment into conversion buffers (called from worker threads)
+    void convertSegment(segment& seg, convertBuffers& bufs);
+    /// start a new chunk in a segment
+    void beginSegChunk(struct nk_draw_list* list, segment& seg, convertBuffers& bufs, const struct nk_rect& clipRect);
+    /// finish current chunk in a segment and record its draw commands
+    void endSegChunk(struct nk_draw_list* list, segment& seg, convertBuffers& bufs);
+    /// remap the UVs of an image draw command into its image atlas page
+    void remapAtlasUVs(convertBuffers& bufs, const segChunk& chunk, int elemOffset, int elemCount, const float* uvRect) const;
+    /// test if a nuklear command can be rendered as instanced quads
+    bool instanceable(const struct nk_command* cmd) const;
+    /// convert a nuklear command into instanced quads (called from worker threads)
+    void convertInstances(segment& seg, convertBuffers& bufs, const struct nk_command* cmd, const struct nk_rect& clipRect) const;
+    /// append an instanced quad to a segment, unless it is clipped away
+    void pushInstance(segment& seg, convertBuffers& bufs, int imageId, const struct nk_rect& clipRect, float x0, float y0, float x1, float y1, struct nk_vec2 uv0, struct nk_vec2 uv1, struct nk_color col, int radius, int thickness) const;
+    /// glyph caches of dynamic fonts
+    enum glyphType {
+        CoverageGlyphs = 0,
+        SDFGlyphs,
+        NumGlyphTypes
+    };
+    /// add a dynamic font using one of the glyph caches
+    struct nk_user_font* addDynamicFont(const Buffer& ttfData, float fontHeight, glyphType type);
+    /// nk_user_font text width callback of dynamic fonts
+    static float dynamicFontWidth(nk_handle handle, float height, const char* text, int len);
+    /// nk_user_font glyph query callback of dynamic fonts (called during geometry conversion)
+    static void dynamicFontQuery(nk_handle handle, float height, struct nk_user_font_glyph* glyph, nk_rune codepoint, nk_rune nextCodepoint);
+    /// wrap a font's width callback with a text width cache (NKUISetup::TextWidthCache)
+    void cacheTextWidths(struct nk_user_font* font);
+    /// nk_user_font text width callback of fonts with a text width cache
+    static float cachedFontWidth(nk_handle handle, float height, const char* text, int len);
+    /// nk_user_font glyph query callback of fonts with a text width cache, forwards to the wrapped font
+    static void cachedFontQuery(nk_handle handle, float height, struct nk_user_font_glyph* glyph, nk_rune codepoint, nk_rune nextCodepoint);
+    /// gather text width cache hits and misses of the current frame
+    void updateTextWidthStats();
+    /// lookup a glyph in the glyph cache, rasterize on demand
+    void dynamicGlyph(dynamicFont* font, nk_rune codepoint, nkuiGlyphCache::glyph& outGlyph);
+    /// create and update the glyph cache textures if they have changed
+    void uploadGlyphCaches();
+    /// allocate or free image handles of image atlas pages
+    void updateAtlasPageImages();
+    /// create and update textures of changed image atlas pages
+    void uploadAtlasPages();
+    /// append a converted segment to the geometry chunks, in place if it was converted into the main buffers
+    void joinSegment(const segment& seg, const convertBuffers& bufs, bool inPlace, int fbWidth, int fbHeight);
+    /// get the stream mesh of a geometry chunk, create on demand
+    Id chunkMesh(int chunkIndex);
+    /// create a new stream mesh for a geometry chunk
+    Id createChunkMesh();
+    /// quantize the vertices of a geometry chunk into packedVertices, returns byte size
+    int packVertices(int chunkIndex);
+    /// switch to the next geometry buffer before uploading a frame's geometry
+    void nextGeomBuffer();
+    /// index into chunkMeshes or instMeshes of a chunk in the current geometry buffer
+    int meshIndex(int chunkIndex) const;
+    /// add a draw command, merge into previous batch if possible
+    void addDrawCmd(int chunkIndex, int imageId, const struct nk_rect& clipRect, int elemOffset, int elemCount, int fbWidth, int fbHeight);
+    /// add an instanced draw command, merge into previous instanced batch if possible
+    void addInstDrawCmd(const segDrawCmd& sdc, const convertBuffers& bufs, int fbWidth, int fbHeight);
+    /// clip a draw command's clip rect against the framebuffer, returns false if nothing is visible
+    bool clipDrawCmd(drawCmd& dc, const struct nk_rect& clipRect, int fbWidth, int fbHeight);
+    /// try to merge a draw command into the previous one if their clip rects allow it
+    bool mergeDrawCmd(drawCmd& prev, const drawCmd& dc) const;
+    /// get the instance stream mesh of an instance chunk, create on demand
+    Id instChunkMesh(int instChunkIndex);
+    /// test if the geometry of a range of indices is inside a rectangle
+    bool geomInsideRect(int chunkIndex, int elemOffset, int elemCount, int x0, int y0, int x1, int y1) const;
+    /// issue draw calls for the recorded draw commands
+    void submit(int fbWidth, int fbHeight);
+    /// submit into the offscreen render target or the current pass
+    void submitFrame(int fbWidth, int fbHeight);
+    /// create an Oryol texture from baked font atlas pixels and bind to a new image handle
+    struct nk_image createFontImage(const void* pixels, int width, int height, enum nk_font_atlas_format format);
+    /// create the pipeline state object for a UI shader
+    Id createPipeline(const ShaderSetup& shdSetup, bool instanced = false);
+    /// create the offscreen render target and the resources to composite it
+    void createOffscreenResources();
+    /// bake a font atlas or load it from a cache, and create its texture, return true if cache was used
+    bool endFontAtlas(nk_font_atlas* atlas, Buffer* cache);
+    /// compute the cache key of a font atlas from its font configs
+    uint64 fontAtlasKey(const nk_font_atlas* atlas, enum nk_font_atlas_format format) const;
+    /// write a baked font atlas into a cache blob
+    void saveFontAtlas(const nk_font_atlas* atlas, uint64 key, enum nk_font_atlas_format format, const void* pixels, int width, int height, Buffer& cache) const;
+    /// restore a font atlas from a cache blob, return false if the blob is stale
+    bool loadFontAtlas(nk_font_atlas* atlas, uint64 key, enum nk_font_atlas_format format, const Buffer& cache);
 
-    static const int MaxNumVertices = 64 * 1024;
-    static const int MaxNumIndices = 128 * 1024;
     static const int MaxNumFontAtlases = 4;
+    /// nuklear asserts if a 16-bit indexed draw list reaches this many vertices
+    static const int MaxChunkVertices = NK_USHORT_MAX - 1;
 
     bool isValid = false;
+    bool headless = false;
+    int headlessWidth = 0;
+    int headlessHeight = 0;
+
+    /// offscreen rendering, the UI is rendered into offscreenTexture only when
+    /// it has changed, and composited as a quad at compositeRect
+    bool offscreen = false;
+    int offscreenWidth = 0;
+    int offscreenHeight = 0;
+    bool offscreenValid = false;
+    Id offscreenTexture;
+    Id offscreenPass;
+    Id compositePipeline;
+    Id compositeMesh;
+    DrawState compositeDrawState;
+    float compositeRect[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    /// fixed nuklear context memory block (nullptr if the context grows on demand)
+    void* ctxMemory = nullptr;
+    bool ctxOverflowWarned = false;
+    nkuiMemPool ctxPool;
+    nkuiMemPool cmdPool;
+    nkuiMemPool geomPool;
+    nkuiMemPool atlasPool;
+    struct nk_allocator ctxAlloc;
+    struct nk_allocator cmdAlloc;
+    struct nk_allocator geomAlloc;
+    struct nk_allocator atlasAlloc;
     nk_font_atlas defaultAtlas;
     nk_font* defaultFont = nullptr;
-    nk_buffer cmds;
-    nk_buffer vbuf;
-    nk_buffer ibuf;
     nk_convert_config config;
+    /// pick circle, arc and curve segment counts from their size in pixels
+    bool adaptiveTessellation = false;
+    nkuiTessellator tessellator;
+
+    /// buffers which receive the output of nuklear draw lists
+    struct convertBuffers {
+        nk_buffer vbuf;
+        nk_buffer ibuf;
+        nk_buffer cmds;
+        /// nkui_instance records of instanced segment chunks
+        nk_buffer inst;
+    };
+    /// main buffers, the final geometry ends up here
+    convertBuffers buffers;
+    /// per-worker buffers for parallel conversion (index 0 is the main thread)
+    Array<convertBuffers> workerBuffers;
+    nkuiWorkerPool workerPool;
 
     ResourceLabel gfxResLabel;
     Id whiteTexture;
     DrawState drawState;
-    static const int MaxImages = 256;
-    StaticArray<Id, MaxImages> images;
+
+    /// image handles are (generation << ImageSlotBits) | slot, so stale handles can be detected
+    static const int ImageSlotBits = 20;
+    static const int MaxImages = 1 << ImageSlotBits;
+    static const int ImageSlotMask = MaxImages - 1;
+    static const int MaxImageGeneration = (1 << (31 - ImageSlotBits)) - 1;
+    struct imageEntry {
+        /// the bound texture, invalid if not bound yet
+        Id texture;
+        /// incremented when the slot is freed, never 0
+        int generation = 1;
+        /// true if the slot is currently allocated
+        bool allocated = false;
+        /// true if the texture is an alpha-only font atlas
+        bool alpha = false;
+        /// true if the texture is an SDF glyph cache
+        bool sdf = false;
+        /// entry in the image atlas (InvalidIndex if not in atlas)
+        int atlasEntry = InvalidIndex;
+        /// resource label of a texture owned by the image handle
+        ResourceLabel label;
+    };
+    /// lookup the entry of a live image handle, nullptr if handle is stale or invalid
+    const imageEntry* lookupImage(int imageId) const;
+    Array<imageEntry> images;
+    bool alphaFontAtlas = false;
+    Id rgbaPipeline;
+    Id alphaPipeline;
+    Id sdfPipeline;
+    Id instRgbaPipeline;
+    Id instAlphaPipeline;
+    Id instSdfPipeline;
     Array<int> freeImageSlots;
+    nkuiImageAtlas imageAtlas;
+    int imageAtlasMaxImageSize = 0;
+    /// image handles of the image atlas pages (0 if page is evicted)
+    Array<int> atlasPageImages;
+
+    /// dynamic fonts share a glyph cache per glyph type, the glyph key is (font index << 21) | codepoint
+    static const int MaxNumDynamicFonts = 2048;
+    /// SDF glyphs are rasterized at this oversampling factor before the distance transform
+    static const int SDFOversample = 4;
+    Array<dynamicFont*> dynamicFonts;
+    StaticArray<nkuiGlyphCache, NumGlyphTypes> glyphCaches;
+    StaticArray<int, NumGlyphTypes> glyphCacheImages;
+    int glyphCacheSize = 0;
+    /// max number of cached text widths per font (0 if disabled)
+    int textWidthCacheSize = 0;
+    Array<cachedFont*> cachedFonts;
+    float sdfSpread = 0.0f;
+    #if ORYOL_HAS_THREADS
+    std::mutex glyphCacheMutex;
+    #endif
     int curFontAtlas = 0;
     StaticArray<nk_font_atlas, MaxNumFontAtlases> fontAtlases;
 
-    struct nkui_draw_vertex vertexData[MaxNumVertices];
-    nk_draw_index indexData[MaxNumIndices];
+    /// a range of vertices and indices which goes into its own stream mesh
+    struct geomChunk {
+        int vtxByteOffset = 0;
+        int vtxByteSize = 0;
+        int idxByteOffset = 0;
+        int idxByteSize = 0;
+    };
+    Array<geomChunk> chunks;
+    /// stream meshes of all geometry buffers, indexed by meshIndex()
+    Array<Id> chunkMeshes;
+    /// geometry buffers are used round-robin, one per frame with geometry upload
+    int numGeomBuffers = 1;
+    int curGeomBuffer = InvalidIndex;
+    VertexLayout meshLayout;
+    /// geometry chunks are uploaded as nkui_compact_vertex if compactVertices is set
+    VertexLayout compactLayout;
+    bool compactVertices = false;
+    /// staging memory for the packed vertices of one geometry chunk
+    nkui_compact_vertex* packedVertices = nullptr;
+    int chunkNumVertices = 0;
+    int chunkNumIndices = 0;
+    int maxNumChunks = 0;
+    /// set once a chunk had to be dropped, all remaining geometry is dropped too
+    bool chunksExhausted = false;
+
+    /// instanced quad renderer, rects, glyphs and images are rendered as
+    /// nkui_instance records, each instanced draw command gets its own
+    /// instance stream mesh since instanced draws have no base instance
+    bool instancedQuads = false;
+    int chunkNumInstances = 0;
+    int maxNumInstChunks = 0;
+    struct instChunk {
+        int byteOffset = 0;
+        int byteSize = 0;
+    };
+    Array<instChunk> instChunks;
+    Array<Id> instMeshes;
+    /// the instance records of all instance chunks
+    nk_buffer instData;
+    Id quadMesh;
+    VertexLayout quadLayout;
+    VertexLayout instLayout;
+
+    /// a draw command of a converted segment
+    struct segDrawCmd {
+        int imageId = 0;
+        struct nk_rect clipRect;
+        /// number of indices, or instances in instanced chunks
+        int elemCount = 0;
+        /// byte offset of the first instance record in convertBuffers::inst
+        int instOffset = 0;
+    };
+    /// a part of a converted segment with segment-relative 16-bit indices
+    struct segChunk {
+        int vtxByteOffset = 0;
+        int vtxByteSize = 0;
+        int idxByteOffset = 0;
+        int idxByteSize = 0;
+        int firstDrawCmd = 0;
+        int numDrawCmds = 0;
+        int numCmds = 0;
+        /// true if the chunk only has instanced draw commands and no geometry
+        bool instanced = false;
+    };
+    /// a run of nuklear commands (usually one window), converted as a unit
+    struct segment {
+        const struct nk_command* first = nullptr;
+        int numCmds = 0;
+        /// the scissor rect in effect at the start of the segment
+        struct nk_rect clipRect;
+        /// worker which converted the segment
+        int worker = 0;
+        int numDroppedCmds = 0;
+        Array<segChunk> chunks;
+        Array<segDrawCmd> drawCmds;
+    };
+    /// segments are never removed to keep their arrays allocated
+    Array<segment> segments;
+    int numSegments = 0;
+    /// sorted start offsets of window command lists
+    Array<int> segmentStarts;
+    std::atomic<int> nextSegment;
+
+    /// a batched draw command, clip rect is framebuffer-clipped, origin top-left
+    struct drawCmd {
+        int chunk = 0;
+        int imageId = 0;
+        int clipX = 0;
+        int clipY = 0;
+        int clipW = 0;
+        int clipH = 0;
+        int elemOffset = 0;
+        /// number of indices, or instances if instanced
+        int elemCount = 0;
+        /// true if all geometry is inside the clip rect (scissor has no effect)
+        bool insideClip = false;
+        /// instance chunk of an instanced draw command, InvalidIndex if not instanced
+        int instChunk = InvalidIndex;
+    };
+    Array<drawCmd> drawCmds;
+
+    /// the command stream of the current frame, in the nuklear context or a replayed capture
+    struct cmdStream {
+        const uint8* base = nullptr;
+        int size = 0;
+        /// offset of the first command, -1 if empty
+        int begin = -1;
+    };
+    cmdStream cmds;
+
+    /// capture and replay, fonts are identified by their index in userFonts
+    Buffer* capture = nullptr;
+    Buffer captureCmds;
+    Buffer captureScratch;
+    bool captureCmdsValid = false;
+    int captureCmdsBegin = -1;
+    Buffer replayCmds;
+    inputState curInput;
+    Array<nk_rune> curRunes;
+    Array<const struct nk_user_font*> userFonts;
+
+    bool retainedMode = false;
+    bool geomValid = false;
+    int prevCmdBegin = 0;
+    int prevFbWidth = 0;
+    int prevFbHeight = 0;
+    Buffer prevCmdStream;
+
+    /// idle-frame detection
+    bool idleFrames = false;
+    bool needsUpdate = true;
+    int idleSettleFrames = 0;
+    int numUpdateFrames = 0;
+    bool updateRequested = false;
+    TimePoint updateRequestTime;
+    Duration updateDelay;
+
+    /// stats of the frame currently in progress
+    NKUIFrameStats curFrameStats;
+    /// stats of the last completed frame
+    NKUIFrameStats lastFrameStats;
+    /// ring buffer of completed frame stats
+    Array<NKUIFrameStats> frameStatsHistory;
+    int frameStatsWindowSize = 0;
+    int frameStatsHead = 0;
 };
 
+//------------------------------------------------------------------------------
+inline Id
+nkuiWrapper::OffscreenTexture() const {
+    return this->offscreenTexture;
+}
+
+//------------------------------------------------------------------------------
+inline bool
+nkuiWrapper::NeedsUpdate() const {
+    return this->needsUpdate;
+}
+
+//------------------------------------------------------------------------------
+inline const NKUIFrameStats&
+nkuiWrapper::FrameStats() const {
+    return this->lastFrameStats;
+}
+
+//------------------------------------------------------------------------------
+inline const nkuiWrapper::imageEntry*
+nkuiWrapper::lookupImage(int imageId) const {
+    const int slot = imageId & ImageSlotMask;
+    if (slot < this->images.Size()) {
+        const imageEntry& entry = this->images[slot];
+        if (entry.allocated && ((imageId >> ImageSlotBits) == entry.generation)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+inline const struct nk_command*
+nkuiWrapper::firstCmd() const {
+    return (this->cmds.begin >= 0) ? (const struct nk_command*)(this->cmds.base + this->cmds.begin) : nullptr;
+}
+
+//------------------------------------------------------------------------------
+inline const struct nk_command*
+nkuiWrapper::nextCmd(const struct nk_command* cmd) const {
+    return (cmd->next < nk_size(this->cmds.size)) ? (const struct nk_command*)(this->cmds.base + cmd->next) : nullptr;
+}
+
+//------------------------------------------------------------------------------
+inline int
+nkuiWrapper::meshIndex(int chunkIndex) const {
+    return chunkIndex * this->numGeomBuffers + this->curGeomBuffer;
+}
+
 } // namespace _priv
 } // namespace Oryol
@@ -0,0 +1,424 @@
+//------------------------------------------------------------------------------
+//  NKUIBench.cc
+//
+//  Headless NKUI benchmark: builds synthetic UIs of different sizes,
+//  runs them through NKUI in headless mode (no Gfx or Input), and
+//  writes one JSON object per scenario and size to stdout.
+//
+//  Usage: NKUIBench [-retained] [-atlas] [-instanced] [-compact] [-adaptive] [-textcache] [-geombudget bytes] [-frames N]
+//                   [-capture prefix] [-replay file]
+//
+//  -capture writes the timed frames of each scenario to prefix-scenario-size.nkcap,
+//  -replay only replays a capture (from NKUI::BeginCapture()) and reports it as scenario "replay".
+//------------------------------------------------------------------------------
+#include "Pre.h"
+#include "Core/Core.h"
+#include "Core/Time/Clock.h"
+#include "Core/Containers/Buffer.h"
+#include "NKUI/NKUI.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace Oryol;
+
+typedef void (*buildFunc)(nk_context* ctx, int size);
+
+static const int NumWarmupFrames = 10;
+static const int NumImages = 64;
+static struct nk_image images[NumImages];
+static bool imageAtlas = false;
+static bool instancedQuads = false;
+static bool compactVertices = false;
+static bool adaptiveTessellation = false;
+static bool textWidthCache = false;
+static int geometryBudget = 0;
+static const char* capturePrefix = nullptr;
+static char longText[64 * 1024 + 1];
+
+//------------------------------------------------------------------------------
+void
+buildWindows(nk_context* ctx, int numWindows) {
+    static float sliderValue = 0.5f;
+    static int checked = 1;
+    static nk_size progress = 40;
+    char title[32];
+    for (int i = 0; i < numWindows; i++) {
+        snprintf(title, sizeof(title), "Window %d", i);
+        const float x = float((i % 8) * 150);
+        const float y = float((i / 8) * 90);
+        if (nk_begin(ctx, title, nk_rect(x, y, 150, 180), NK_WINDOW_BORDER|NK_WINDOW_TITLE|NK_WINDOW_MOVABLE)) {
+            nk_layout_row_dynamic(ctx, 20, 2);
+            nk_label(ctx, "Label:", NK_TEXT_LEFT);
+            nk_button_label(ctx, "Button");
+            nk_layout_row_dynamic(ctx, 20, 1);
+            nk_slider_float(ctx, 0.0f, &sliderValue, 1.0f, 0.01f);
+            nk_checkbox_label(ctx, "Checkbox", &checked);
+            nk_progress(ctx, &progress, 100, NK_FIXED);
+        }
+        nk_end(ctx);
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+buildTable(nk_context* ctx, int numRows) {
+    static const int NumCols = 8;
+    char cell[32];
+    if (nk_begin(ctx, "Table", nk_rect(0, 0, 1280, 720), NK_WINDOW_BORDER|NK_WINDOW_TITLE)) {
+        for (int row = 0; row < numRows; row++) {
+            nk_layout_row_dynamic(ctx, 18, NumCols);
+            for (int col = 0; col < NumCols; col++) {
+                snprintf(cell, sizeof(cell), "r%d c%d", row, col);
+                nk_label(ctx, cell, NK_TEXT_LEFT);
+            }
+        }
+    }
+    nk_end(ctx);
+}
+
+//------------------------------------------------------------------------------
+void
+buildText(nk_context* ctx, int numChars) {
+    if (nk_begin(ctx, "Text", nk_rect(0, 0, 1280, 720), NK_WINDOW_BORDER|NK_WINDOW_TITLE)) {
+        // split the text into lines of 128 characters
+        static const int LineLength = 128;
+        for (int pos = 0; pos < numChars; pos += LineLength) {
+            const int len = (numChars - pos) < LineLength ? (numChars - pos) : LineLength;
+            nk_layout_row_dynamic(ctx, 16, 1);
+            nk_text(ctx, &longText[pos], len, NK_TEXT_LEFT);
+        }
+    }
+    nk_end(ctx);
+}
+
+//------------------------------------------------------------------------------
+void
+buildImages(nk_context* ctx, int numImages) {
+    if (nk_begin(ctx, "Images", nk_rect(0, 0, 1280, 720), NK_WINDOW_BORDER|NK_WINDOW_TITLE)) {
+        nk_layout_row_static(ctx, 32, 32, 32);
+        for (int i = 0; i < numImages; i++) {
+            nk_image(ctx, images[i % NumImages]);
+        }
+    }
+    nk_end(ctx);
+}
+
+//------------------------------------------------------------------------------
+void
+buildCharts(nk_context* ctx, int numCharts) {
+    static const int NumPoints = 256;
+    if (nk_begin(ctx, "Charts", nk_rect(0, 0, 1280, 720), NK_WINDOW_BORDER|NK_WINDOW_TITLE)) {
+        nk_layout_row_dynamic(ctx, 100, 4);
+        for (int i = 0; i < numCharts; i++) {
+            const enum nk_chart_type type = (i & 1) ? NK_CHART_COLUMN : NK_CHART_LINES;
+            if (nk_chart_begin(ctx, type, NumPoints, -1.0f, 1.0f)) {
+                for (int p = 0; p < NumPoints; p++) {
+                    nk_chart_push(ctx, float((p * 37 + i * 11) % 200 - 100) / 100.0f);
+                }
+                nk_chart_end(ctx);
+            }
+        }
+    }
+    nk_end(ctx);
+}
+
+//------------------------------------------------------------------------------
+void
+buildShapes(nk_context* ctx, int numNodes) {
+    // a node-editor-like canvas: small pin circles connected by curves,
+    // and every 16th node has a large gauge circle with an arc
+    if (nk_begin(ctx, "Shapes", nk_rect(0, 0, 1280, 720), NK_WINDOW_BORDER|NK_WINDOW_TITLE)) {
+        struct nk_command_buffer* canvas = nk_window_get_canvas(ctx);
+        const struct nk_color pinColor = nk_rgb(200, 200, 80);
+        const struct nk_color linkColor = nk_rgb(100, 100, 200);
+        for (int i = 0; i < numNodes; i++) {
+            const float x0 = float((i * 53) % 1200 + 20);
+            const float y0 = float((i * 31) % 660 + 40);
+            const float x1 = float((i * 97 + 300) % 1200 + 20);
+            const float y1 = float((i * 71 + 200) % 660 + 40);
+            nk_fill_circle(canvas, nk_rect(x0 - 3, y0 - 3, 6, 6), pinColor);
+            nk_fill_circle(canvas, nk_rect(x1 - 3, y1 - 3, 6, 6), pinColor);
+            nk_stroke_curve(canvas, x0, y0, x0 + 50, y0, x1 - 50, y1, x1, y1, 1.0f, linkColor);
+            if ((i % 16) == 0) {
+                nk_stroke_circle(canvas, nk_rect(x0 - 100, y0 - 100, 200, 200), 2.0f, linkColor);
+                nk_fill_arc(canvas, x0, y0, 90.0f, 0.0f, 4.0f, pinColor);
+            }
+        }
+    }
+    nk_end(ctx);
+}
+
+//------------------------------------------------------------------------------
+void
+buildList(nk_context* ctx, int numRows) {
+    // a log-viewer-like list, every 10th row is a taller two-line row
+    static const int NumCols = 8;
+    static NKUIListView list;
+    if (list.NumRows() != numRows) {
+        list = NKUIListView();
+        list.SetNumRows(numRows, 18);
+        for (int row = 0; row < numRows; row += 10) {
+            list.SetRowHeight(row, 36);
+        }
+    }
+    char cell[32];
+    if (nk_begin(ctx, "List", nk_rect(0, 0, 1280, 720), NK_WINDOW_BORDER|NK_WINDOW_TITLE)) {
+        nk_layout_row_dynamic(ctx, 680, 1);
+        list.Draw(ctx, "Rows", NK_WINDOW_BORDER, NumCols, [&cell](nk_context* rowCtx, int row) {
+            for (int col = 0; col < NumCols; col++) {
+                snprintf(cell, sizeof(cell), "r%d c%d", row, col);
+                nk_label(rowCtx, cell, NK_TEXT_LEFT);
+            }
+        });
+    }
+    nk_end(ctx);
+}
+
+//------------------------------------------------------------------------------
+static int
+numAllocs(const NKUIStats& stats) {
+    return stats.ContextMemory.NumAllocs + stats.CommandMemory.NumAllocs +
+           stats.GeometryMemory.NumAllocs + stats.FontAtlasMemory.NumAllocs;
+}
+
+//------------------------------------------------------------------------------
+static int
+peakBytes(const NKUIStats& stats) {
+    return stats.ContextMemory.PeakBytes + stats.CommandMemory.PeakBytes +
+           stats.GeometryMemory.PeakBytes + stats.FontAtlasMemory.PeakBytes;
+}
+
+//------------------------------------------------------------------------------
+static int
+budgetOverruns(const NKUIStats& stats) {
+    return stats.ContextMemory.NumBudgetOverruns + stats.CommandMemory.NumBudgetOverruns +
+           stats.GeometryMemory.NumBudgetOverruns + stats.FontAtlasMemory.NumBudgetOverruns;
+}
+
+//------------------------------------------------------------------------------
+static void
+setupNKUI(int numFrames, bool retained) {
+    NKUISetup setup;
+    setup.Headless = true;
+    setup.RetainedMode = retained;
+    setup.FrameStatsWindowSize = numFrames;
+    setup.ImageAtlas = imageAtlas;
+    setup.InstancedQuads = instancedQuads;
+    setup.CompactVertices = compactVertices;
+    setup.AdaptiveTessellation = adaptiveTessellation;
+    setup.TextWidthCache = textWidthCache;
+    setup.GeometryMemoryBudget = geometryBudget;
+    NKUI::Setup(setup);
+    static const int ImageSize = 16;
+    uint32 pixels[ImageSize * ImageSize];
+    for (int i = 0; i < NumImages; i++) {
+        images[i] = NKUI::AllocImage();
+        for (uint32& p : pixels) {
+            p = 0xFF000000 | (i * 0x030507);
+        }
+        NKUI::BindImagePixels(images[i], ImageSize, ImageSize, pixels);
+    }
+}
+
+//------------------------------------------------------------------------------
+static void
+printResult(const char* name, int size, int numFrames, bool retained, int64 buildTicks, int skippedBefore, int allocsBefore) {
+    const NKUIFrameTimings timings = NKUI::FrameTimings();
+    const NKUIFrameStats& frame = NKUI::FrameStats();
+    const NKUIStats& stats = NKUI::Stats();
+    printf("{\"scenario\":\"%s\",\"size\":%d,\"retained\":%s,\"atlas\":%s,\"instanced\":%s,\"compact\":%s,\"adaptive\":%s,\"textcache\":%s,\"geom_budget\":%d,\"frames\":%d,"
+        "\"new_frame_us\":%.3f,\"build_us\":%.3f,"
+        "\"convert_us\":{\"min\":%.3f,\"avg\":%.3f,\"max\":%.3f},"
+        "\"upload_us\":{\"min\":%.3f,\"avg\":%.3f,\"max\":%.3f},"
+        "\"submit_us\":{\"min\":%.3f,\"avg\":%.3f,\"max\":%.3f},"
+        "\"draw_us\":%.3f,"
+        "\"vertices\":%d,\"indices\":%d,\"instances\":%d,\"uploaded_bytes\":%d,"
+        "\"nk_commands\":%d,\"draw_calls\":%d,\"chunks\":%d,"
+        "\"text_width_hits\":%d,\"text_width_misses\":%d,"
+        "\"skipped_frames\":%d,\"allocs\":%d,\"peak_bytes\":%d,\"budget_overruns\":%d}\n",
+        name, size, retained ? "true" : "false", imageAtlas ? "true" : "false", instancedQuads ? "true" : "false", compactVertices ? "true" : "false", adaptiveTessellation ? "true" : "false", textWidthCache ? "true" : "false", geometryBudget, numFrames,
+        timings.NewFrame.Avg.AsMicroSeconds(),
+        Duration(buildTicks / numFrames).AsMicroSeconds(),
+        timings.Convert.Min.AsMicroSeconds(), timings.Convert.Avg.AsMicroSeconds(), timings.Convert.Max.AsMicroSeconds(),
+        timings.Upload.Min.AsMicroSeconds(), timings.Upload.Avg.AsMicroSeconds(), timings.Upload.Max.AsMicroSeconds(),
+        timings.Submit.Min.AsMicroSeconds(), timings.Submit.Avg.AsMicroSeconds(), timings.Submit.Max.AsMicroSeconds(),
+        timings.Convert.Avg.AsMicroSeconds() + timings.Upload.Avg.AsMicroSeconds() + timings.Submit.Avg.AsMicroSeconds(),
+        frame.NumVertices, frame.NumIndices, frame.NumInstances, frame.NumUploadedBytes,
+        frame.NumNuklearCommands, frame.NumDrawCalls, frame.NumChunks,
+        frame.NumTextWidthHits, frame.NumTextWidthMisses,
+        stats.NumSkippedFrames - skippedBefore,
+        numAllocs(stats) - allocsBefore,
+        peakBytes(stats),
+        budgetOverruns(stats));
+    fflush(stdout);
+}
+
+//------------------------------------------------------------------------------
+void
+runScenario(const char* name, buildFunc build, int size, int numFrames, bool retained) {
+    setupNKUI(numFrames, retained);
+    for (int i = 0; i < NumWarmupFrames; i++) {
+        build(NKUI::NewFrame(), size);
+        NKUI::Draw();
+    }
+    Buffer capture;
+    if (capturePrefix) {
+        NKUI::BeginCapture(capture);
+    }
+    const int allocsBefore = numAllocs(NKUI::Stats());
+    const int skippedBefore = NKUI::Stats().NumSkippedFrames;
+    int64 buildTicks = 0;
+    for (int i = 0; i < numFrames; i++) {
+        nk_context* ctx = NKUI::NewFrame();
+        TimePoint start = Clock::Now();
+        build(ctx, size);
+        buildTicks += Clock::Since(start).AsTicks();
+        NKUI::Draw();
+    }
+    printResult(name, size, numFrames, retained, buildTicks, skippedBefore, allocsBefore);
+    if (capturePrefix) {
+        NKUI::EndCapture();
+        char path[256];
+        snprintf(path, sizeof(path), "%s-%s-%d.nkcap", capturePrefix, name, size);
+        FILE* fp = fopen(path, "wb");
+        if (fp) {
+            fwrite(capture.Data(), 1, capture.Size(), fp);
+            fclose(fp);
+        }
+        else {
+            fprintf(stderr, "NKUIBench: failed to write '%s'\n", path);
+        }
+    }
+    NKUI::Discard();
+}
+
+//------------------------------------------------------------------------------
+static bool
+replayNext(const Buffer& capture, int& offset) {
+    // loop the capture if it has less frames than requested
+    if (NKUI::ReplayFrame(capture, offset)) {
+        return true;
+    }
+    offset = 0;
+    return NKUI::ReplayFrame(capture, offset);
+}
+
+//------------------------------------------------------------------------------
+void
+runReplay(const char* path, int numFrames, bool retained) {
+    Buffer capture;
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "NKUIBench: failed to open '%s'\n", path);
+        return;
+    }
+    uint8 chunk[64 * 1024];
+    size_t num;
+    while ((num = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        capture.Add(chunk, int(num));
+    }
+    fclose(fp);
+
+    // the images are created in the same order as in runScenario(),
+    // so that captures of NKUIBench scenarios have matching image handles
+    setupNKUI(numFrames, retained);
+    int offset = 0;
+    for (int i = 0; i < NumWarmupFrames; i++) {
+        if (!replayNext(capture, offset)) {
+            fprintf(stderr, "NKUIBench: '%s' is not a valid capture\n", path);
+            NKUI::Discard();
+            return;
+        }
+    }
+    const int allocsBefore = numAllocs(NKUI::Stats());
+    const int skippedBefore = NKUI::Stats().NumSkippedFrames;
+    for (int i = 0; i < numFrames; i++) {
+        replayNext(capture, offset);
+    }
+    printResult("replay", capture.Size(), numFrames, retained, 0, skippedBefore, allocsBefore);
+    NKUI::Discard();
+}
+
+//------------------------------------------------------------------------------
+int
+main(int argc, const char** argv) {
+    bool retained = false;
+    int numFrames = 100;
+    const char* replayPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "-retained")) {
+            retained = true;
+        }
+        else if (0 == strcmp(argv[i], "-atlas")) {
+            imageAtlas = true;
+        }
+        else if (0 == strcmp(argv[i], "-instanced")) {
+            instancedQuads = true;
+        }
+        else if (0 == strcmp(argv[i], "-compact")) {
+            compactVertices = true;
+        }
+        else if (0 == strcmp(argv[i], "-adaptive")) {
+            adaptiveTessellation = true;
+        }
+        else if (0 == strcmp(argv[i], "-textcache")) {
+            textWidthCache = true;
+        }
+        else if ((0 == strcmp(argv[i], "-geombudget")) && ((i + 1) < argc)) {
+            geometryBudget = atoi(argv[++i]);
+        }
+        else if ((0 == strcmp(argv[i], "-frames")) && ((i + 1) < argc)) {
+            numFrames = atoi(argv[++i]);
+        }
+        else if ((0 == strcmp(argv[i], "-capture")) && ((i + 1) < argc)) {
+            capturePrefix = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "-replay")) && ((i + 1) < argc)) {
+            replayPath = argv[++i];
+        }
+    }
+    if (numFrames < 1) {
+        numFrames = 1;
+    }
+    for (int i = 0; i < int(sizeof(longText)) - 1; i++) {
+        longText[i] = ((i % 7) == 6) ? ' ' : char('a' + (i % 26));
+    }
+
+    Core::Setup();
+    if (replayPath) {
+        runReplay(replayPath, numFrames, retained);
+        Core::Discard();
+        return 0;
+    }
+    static const int windowSizes[] = { 1, 4, 16, 64 };
+    for (int size : windowSizes) {
+        runScenario("windows", buildWindows, size, numFrames, retained);
+    }
+    static const int tableSizes[] = { 100, 1000, 10000 };
+    for (int size : tableSizes) {
+        runScenario("table", buildTable, size, numFrames, retained);
+    }
+    static const int textSizes[] = { 1024, 16 * 1024, 64 * 1024 };
+    for (int size : textSizes) {
+        runScenario("text", buildText, size, numFrames, retained);
+    }
+    static const int imageSizes[] = { 16, 256, 1024 };
+    for (int size : imageSizes) {
+        runScenario("images", buildImages, size, numFrames, retained);
+    }
+    static const int chartSizes[] = { 1, 16, 64 };
+    for (int size : chartSizes) {
+        runScenario("charts", buildCharts, size, numFrames, retained);
+    }
+    static const int shapeSizes[] = { 100, 1000, 4000 };
+    for (int size : shapeSizes) {
+        runScenario("shapes", buildShapes, size, numFrames, retained);
+    }
+    static const int listSizes[] = { 1000, 100000, 1000000 };
+    for (int size : listSizes) {
+        runScenario("list", buildList, size, numFrames, retained);
+    }
+    Core::Discard();
+    return 0;
+}